@@ -1,11 +1,16 @@
 #ifndef OLEDDISPLAYFONTS_h
 #define OLEDDISPLAYFONTS_h
 
-#ifdef __MBED__
+// constexpr so the tables can be read at compile time (page_fonts.h); only
+// what is converted from them ends up in flash
+
+#include <stdint.h>
+
+#ifndef PROGMEM
 #define PROGMEM
 #endif
 
-const uint8_t ArialMT_Plain_10[] PROGMEM = {
+constexpr uint8_t ArialMT_Plain_10[] PROGMEM = {
   0x0A, // Width: 10
   0x0D, // Height: 13
   0x20, // First Char: 32
@@ -429,7 +434,7 @@ const uint8_t ArialMT_Plain_10[] PROGMEM = {
   0x20,0x00,0xC8,0x09,0x00,0x06,0xC8,0x01,0x20  // 255
 };
 
-const uint8_t ArialMT_Plain_16[] PROGMEM = {
+constexpr uint8_t ArialMT_Plain_16[] PROGMEM = {
   0x10, // Width: 16
   0x13, // Height: 19
   0x20, // First Char: 32
@@ -852,7 +857,7 @@ const uint8_t ArialMT_Plain_16[] PROGMEM = {
   0x00,0x00,0x00,0xF8,0xFF,0x03,0x80,0x20,0x00,0x40,0x40,0x00,0x40,0x40,0x00,0x40,0x40,0x00,0x80,0x20,0x00,0x00,0x1F, // 254
   0xC0,0x01,0x00,0x00,0x06,0x02,0x10,0x38,0x02,0x00,0xE0,0x01,0x10,0x38,0x00,0x00,0x07,0x00,0xC0  // 255
 };
-const uint8_t ArialMT_Plain_24[] PROGMEM = {
+constexpr uint8_t ArialMT_Plain_24[] PROGMEM = {
   0x18, // Width: 24
   0x1C, // Height: 28
   0x20, // First Char: 32
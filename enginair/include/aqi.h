@@ -0,0 +1,134 @@
+// enginair aqi.h
+// Air quality indices from the PM readings, kept up to date as samples
+// arrive:
+//   US EPA AQI (2024 PM2.5 breakpoints) from the NowCast of PM2.5 and PM10
+//   EU CAQI (CITEAIR II, background) from the 1 h and 24 h means
+//
+// Samples go into a minute accumulator; each finished minute moves a 60
+// minute ring and its running sum (the 1 h mean), each 60th minute a 24
+// hour ring and its running sum (the 24 h mean) and the 12 h NowCast. So
+// a sample costs a few additions, a minute O(1) and an hour O(12), against
+// re-averaging a day of samples (see "aqi" in bench.cpp). Concentrations
+// stay in PM ticks (0.1 ug/m3, sample.h).
+//
+// Means need 75% of their minutes (hours) to be valid, as the EPA asks of
+// daily means, and NowCast needs 2 of the last 3 hours, so indices appear
+// an hour (NowCast: two) after start and survive short sensor dropouts.
+// A reading stands for the time until the next one is due (the sample
+// period), so sampling less than once a minute (POWER_LOW) still fills
+// every minute it covers; minutes that get a reading of their own use that.
+
+#pragma once
+
+#include <stdint.h>
+
+#define AQI_INVALID 0xFFFF // no value (yet)
+#define AQI_MINUTE_US 60000000
+#define AQI_HOUR_MINUTES 60
+#define AQI_DAY_HOURS 24
+#define AQI_NOWCAST_HOURS 12
+
+// Piecewise linear map from concentration (PM ticks) to index. Bands are
+// contiguous: concLo of one band is concHi of the previous plus one tick
+// for the EPA (which truncates), equal to it for CAQI.
+struct aqi_breakpoint_t {
+    uint16_t concLo;
+    uint16_t concHi;
+    uint16_t indexLo;
+    uint16_t indexHi;
+};
+
+enum aqi_category_t {
+    AQI_GOOD,
+    AQI_MODERATE,
+    AQI_SENSITIVE,      // unhealthy for sensitive groups
+    AQI_UNHEALTHY,
+    AQI_VERY_UNHEALTHY,
+    AQI_HAZARDOUS,
+    AQI_CATEGORIES
+};
+
+// Starts out with no values
+struct aqi_t {
+    uint16_t pm2p5Hour = AQI_INVALID; // running means, PM ticks
+    uint16_t pm2p5Day = AQI_INVALID;
+    uint16_t pm10Hour = AQI_INVALID;
+    uint16_t pm10Day = AQI_INVALID;
+    uint16_t pm2p5NowCast = AQI_INVALID;
+    uint16_t pm10NowCast = AQI_INVALID;
+    uint16_t us = AQI_INVALID;        // US AQI, the higher of the PM2.5 and PM10 indices
+    uint8_t usCategory = AQI_CATEGORIES; // aqi_category_t
+    uint8_t reserved = 0;
+    uint16_t caqiHour = AQI_INVALID;  // EU CAQI, the higher of the PM2.5 and PM10 indices
+    uint16_t caqiDay = AQI_INVALID;
+};
+
+// Index for one pollutant, AQI_INVALID for AQI_INVALID in
+uint16_t aqiUsPm2p5(uint16_t conc);
+uint16_t aqiUsPm10(uint16_t conc);
+uint16_t aqiCaqiHourly(uint16_t pm2p5, uint16_t pm10);
+uint16_t aqiCaqiDaily(uint16_t pm2p5, uint16_t pm10);
+
+aqi_category_t aqiUsCategory(uint16_t index);
+const char *aqiCategoryName(aqi_category_t category);
+
+// Running means and NowCast of one pollutant
+class AqiChannel {
+public:
+    void add(uint16_t value) {
+        _minuteSum += value;
+        _minuteCount++;
+    }
+    // The current minute's mean if no reading arrives in it
+    void hold(uint16_t value) { _minuteHeld = value; }
+    void rollMinute(bool hourDone);
+    void clear();
+
+    uint16_t hourMean() const;
+    uint16_t dayMean() const;
+    uint16_t nowCast() const { return _nowCast; }
+
+private:
+    void rollHour();
+    void updateNowCast();
+
+    uint32_t _minuteSum = 0;
+    uint16_t _minuteCount = 0;
+    uint16_t _minuteHeld = AQI_INVALID;
+    uint16_t _minutes[AQI_HOUR_MINUTES]; // means, AQI_INVALID if no samples
+    uint8_t _minuteHead = 0;
+    uint8_t _minutesFilled = 0;
+    uint32_t _hourSum = 0;               // over the valid entries of _minutes
+    uint8_t _hourValid = 0;
+    uint16_t _hours[AQI_DAY_HOURS];      // means, AQI_INVALID if < 75% data
+    uint8_t _hourHead = 0;
+    uint8_t _hoursFilled = 0;
+    uint32_t _daySum = 0;
+    uint8_t _dayValid = 0;
+    uint16_t _nowCast = AQI_INVALID;
+};
+
+class AqiEngine {
+public:
+    // A PM reading at now (micros, may wrap), standing for the next coverUs
+    void add(uint32_t now, uint16_t pm2p5, uint16_t pm10, uint32_t coverUs);
+
+    // Roll forward to now without a reading, e.g. while the sensor is down
+    void advance(uint32_t now);
+
+    void clear();
+    aqi_t result() const;
+
+private:
+    void rollMinute();
+
+    AqiChannel _pm2p5;
+    AqiChannel _pm10;
+    bool _started = false;
+    uint32_t _last = 0;
+    uint32_t _minuteUs = 0; // into the current minute
+    uint8_t _minute = 0;    // into the current hour
+    uint32_t _coverUs = 0;  // left of the last reading's cover
+    uint16_t _held2p5 = AQI_INVALID;
+    uint16_t _held10 = AQI_INVALID;
+};
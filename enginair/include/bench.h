@@ -0,0 +1,15 @@
+// enginair bench.h
+// On-device microbenchmarks, timed with the RP2040 cycle counter. Built into
+// the rpipico_bench environment (ENGINAIR_BENCH) and run once from setup().
+
+#pragma once
+
+#include <stdint.h>
+
+// Mean cycles per call of fn(i) for i = 0..n-1
+uint32_t benchCycles(void (*fn)(uint32_t i), uint32_t n);
+
+// Print one result line: "bench <name>: <cycles> cyc"
+void benchReport(const char *name, uint32_t cycles);
+
+void benchRunAll();
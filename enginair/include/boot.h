@@ -0,0 +1,28 @@
+// enginair boot.h
+// Boot timing: each stage is stamped once with micros() (time since reset),
+// and the breakdown is printed once the first PM and CO2 values are in.
+
+#pragma once
+
+#include <stdint.h>
+
+enum boot_stage_t {
+    BOOT_SETUP,         // setup() entered
+    BOOT_SENSORS_ISSUED,// sensor reset/stop commands sent
+    BOOT_DISPLAY_READY, // OLED initialised
+    BOOT_SEN50_STARTED, // SEN50 measuring
+    BOOT_SCD40_STARTED, // SCD40 measuring
+    BOOT_FIRST_PM,      // first PM value on its way to the display
+    BOOT_FIRST_CO2,     // first CO2 value on its way to the display
+    BOOT_STAGES
+};
+
+// Stamp a stage; later calls for the same stage are ignored
+void bootMark(boot_stage_t stage);
+bool bootReached(boot_stage_t stage);
+
+// Both first values are in
+bool bootComplete();
+
+// Print the breakdown over serial
+void bootReport();
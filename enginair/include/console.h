@@ -0,0 +1,25 @@
+// enginair console.h
+// Line-based command console on Serial. Commands are "name arg arg...",
+// terminated by CR or LF; "help" lists them. Poll from the core that owns
+// serial output (core 1).
+
+#pragma once
+
+#include <stdint.h>
+
+#define CONSOLE_LINE_SIZE 48
+#define CONSOLE_MAX_ARGS 4
+
+typedef void (*console_fn_t)(uint8_t argc, char **argv);
+
+struct console_cmd_t {
+    const char *name;
+    console_fn_t fn;
+    const char *help; // usage, printed by "help"
+};
+
+void consoleBegin(const console_cmd_t *commands, uint8_t count);
+
+// Read whatever has arrived and run any complete line. Never blocks.
+// Returns true if it ran a command.
+bool consolePoll();
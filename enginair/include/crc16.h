@@ -0,0 +1,13 @@
+// enginair crc16.h
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), for stored and transmitted
+// records. Sensor traffic uses the Sensirion CRC-8 in sensirion.h instead.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CRC16_INIT 0xFFFF
+
+// Continue a CRC over more data: crc16(crc16(CRC16_INIT, a, n), b, m)
+uint16_t crc16(uint16_t crc, const void *data, size_t len);
@@ -0,0 +1,81 @@
+// enginair flash_log.h
+// Append-only measurement log in the top of the Pico's flash, so history
+// survives a power cycle.
+//
+// The log region is a ring of 4 KiB sectors. Each sector holds a header
+// (sequence number, boot number, record count) and one compressed block of
+// records (see history_codec.h). Samples are compressed into a RAM image of
+// the next sector and the whole sector is erased and programmed in one go
+// once the block is full, so each sector is erased once per trip round the
+// ring and XIP is only stalled once per block.
+//
+// Recovery: at boot the sector headers are scanned and writing resumes after
+// the highest sequence number. Header and block each carry a CRC-16, so a
+// write cut short by power loss leaves a sector whose header is ignored at
+// boot or whose block is skipped when read.
+//
+// Numbers for the 1 Hz workload, 1 MiB region (256 sectors, W25Q16 class
+// flash: 45 ms typ. sector erase, 0.4 ms typ. page program), at ~2.5 bytes
+// per compressed record:
+//   ~1600 records per sector -> one sector write every ~27 min
+//   XIP stalled ~52 ms typ. per write (~0.003 % of the time)
+//   the ring holds ~410k samples, about 4.7 days (14.5 h uncompressed)
+//   each sector is erased every ~4.7 days -> 100k cycles last >1000 years
+// Anything still in RAM (up to one block) is lost on power-off; see
+// flashLogFlush().
+
+#pragma once
+
+#include <stdint.h>
+#include "hal.h"
+#include "sample.h"
+#include "history.h"
+#include "history_codec.h"
+
+// The region is the HAL's flash area (HAL_FLASH_SIZE at the top of flash),
+// which must stay clear of the firmware image at the bottom (and of any
+// LittleFS partition, none is configured in platformio.ini).
+#define FLASH_LOG_SIZE HAL_FLASH_SIZE
+#define FLASH_LOG_MAGIC 0x32414E45 // "ENA2": compressed blocks
+
+struct flash_sector_header_t {
+    uint32_t magic;
+    uint32_t sequence; // increases by one per sector written, never wraps
+    uint32_t boot;     // increases by one per power-up
+    uint16_t count;    // records in the block
+    uint16_t length;   // bytes of block data
+    uint16_t dataCrc;  // CRC-16 of the block data
+    uint16_t crc;      // CRC-16 of the header up to here
+};
+
+#define FLASH_LOG_BLOCK_SIZE (HAL_FLASH_SECTOR_SIZE - sizeof(flash_sector_header_t))
+
+struct flash_log_stats_t {
+    uint32_t sectors;  // sectors holding data
+    uint32_t records;  // records in flash
+    uint32_t pending;  // records batched in RAM
+    uint32_t boot;     // this power-up
+    uint32_t writes;   // sectors written since boot
+    uint32_t lastStallUs;
+    uint32_t maxStallUs;
+};
+
+// Scan the log and pick up where the last power-up left off
+void flashLogBegin();
+
+// Batch a sample; writes a sector when the batch is full. Call from core 1:
+// a sector write stalls both cores for the erase and program time.
+void flashLogAppend(const sample_t &sample);
+
+// Write the partly filled batch now (the rest of that sector stays unused)
+void flashLogFlush();
+
+// Record `age` from the flash log, 0 being the newest. Not counting the RAM
+// batch. Returns false if there is no such record.
+// Decodes the block from its start, so walking a whole block this way costs
+// O(n^2); fine for the console.
+bool flashLogGet(uint32_t age, history_record_t &record, uint32_t &boot);
+
+// Totals kept in RAM as sectors are written, so cheap enough to call
+// every frame
+flash_log_stats_t flashLogStats();
@@ -0,0 +1,30 @@
+// enginair fmt.h
+// Heap-free number formatting for the display and serial paths. Everything
+// appends to a caller-provided (usually stack) buffer and returns the new end
+// pointer, so calls chain:
+//
+//     char line[48];
+//     char *p = fmtStr(line, line + sizeof(line), "CO2: ");
+//     p = fmtUint(p, line + sizeof(line), co2);
+//
+// Output is always NUL-terminated and silently truncated at `end`.
+
+#pragma once
+
+#include <stdint.h>
+
+// Append a string
+char *fmtStr(char *p, char *end, const char *s);
+
+// Append an unsigned integer, right-aligned in `width` characters (0: no padding)
+char *fmtUint(char *p, char *end, uint32_t value, uint8_t width = 0);
+
+// Append a fixed-point value given in tenths, with one decimal: 123 -> "12.3"
+char *fmtFixed1(char *p, char *end, int32_t tenths, uint8_t width = 0);
+
+// Append a float rounded to one decimal
+char *fmtFloat1(char *p, char *end, float value, uint8_t width = 0);
+
+// Stack buffer sizes: one display field, one serial line
+#define FMT_FIELD_SIZE 12
+#define FMT_LINE_SIZE 96
@@ -0,0 +1,81 @@
+// enginair hal.h
+// Hardware abstraction: everything the application needs from the board
+// apart from the I2C bus (i2c_bus.h) and the display (oled.h). The RP2040
+// implementation is src/hal_rp2040.cpp; the native build (env:native) links
+// native/ instead, with simulated sensors, display and flash.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Clock and events ---
+
+uint32_t halMicros();
+
+// Microseconds since boot without the 71 minute wrap, for totals over long
+// stretches (power.h)
+uint64_t halMicros64();
+
+// CPU cycle counter, for benchmarks and instrumentation. The native build
+// counts nanoseconds of host time instead.
+uint32_t halCycles();
+
+// halCycles() ticks per microsecond
+uint32_t halCyclesPerMicro();
+
+// Sleep until t (micros) or until any event (interrupt, halSignalEvent() on
+// the other core), whichever comes first
+void halSleepUntil(uint32_t t);
+
+// Sleep until any event (WFE)
+void halWaitEvent();
+
+// Wake the other core out of halWaitEvent()/halSleepUntil() (SEV)
+void halSignalEvent();
+
+// --- Alarm ---
+// A periodic hardware alarm on the timer behind halMicros(). fn runs in
+// interrupt context on the core that started it, with the timer value read
+// on entry (now) and the deadline it was due for. Deadlines are first +
+// n * period, so the alarm never drifts; any passed while interrupts were
+// off (flash writes) are skipped, not made up. It wakes the core from
+// halSleepUntil()/halWaitEvent(). fn must be short: no I2C, no serial.
+
+typedef void (*hal_alarm_fn_t)(uint32_t now, uint32_t due);
+void halAlarmStart(uint32_t first, uint32_t period, hal_alarm_fn_t fn);
+void halAlarmStop();
+
+// --- Serial (USB CDC) ---
+// Safe from both cores: each call holds a lock for its whole output, so a
+// telemetry frame (one halSerialWrite()) or a line (one halSerialPrintln())
+// never interleaves with output from the other core. Nothing spanning two
+// calls is kept together: build a line in one buffer (fmt.h) and send it
+// with a single call. Don't call from interrupt context.
+
+void halSerialBegin();
+void halSerialWrite(const void *data, size_t length);
+
+// text followed by "\r\n"
+void halSerialPrintln(const char *text);
+
+// Next received byte, or -1 if there is none. Never blocks.
+int halSerialRead();
+
+// A host has the port open. Until then, output is discarded.
+bool halSerialConnected();
+
+// --- Flash ---
+// The top HAL_FLASH_SIZE bytes of flash, addressed from 0, for the
+// measurement log.
+
+#define HAL_FLASH_SECTOR_SIZE 4096
+#define HAL_FLASH_SIZE (1024 * 1024)
+
+// Memory-mapped view of the region; reads need no driver
+const uint8_t *halFlashData();
+
+// Erase one sector and program it with data (HAL_FLASH_SECTOR_SIZE bytes).
+// Flash is unreadable meanwhile, so this stalls both cores for the erase
+// and program time.
+void halFlashWriteSector(uint32_t offset, const uint8_t *data);
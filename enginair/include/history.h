@@ -0,0 +1,75 @@
+// enginair history.h
+// In-RAM measurement history in three tiers:
+//   tier 0: every sample (1 s) for the last 10 minutes (600 samples; longer
+//           at the POWER_LOW sample period, see power.h)
+//   tier 1: 1 minute buckets for the last 24 hours
+//   tier 2: 1 hour buckets for the last 30 days
+// Each coarser bucket keeps min/max/mean per channel. Buckets roll up as
+// samples arrive (a running accumulator per tier), so adding a sample costs
+// the same no matter how much history there is. Values stay in sensor ticks
+// (see sample.h); missing values are HISTORY_INVALID.
+
+#pragma once
+
+#include <stdint.h>
+#include "sample.h"
+
+enum history_channel_t {
+    CH_PM1P0,
+    CH_PM2P5,
+    CH_PM4P0,
+    CH_PM10P0,
+    CH_CO2,
+    CH_TEMP,
+    CH_HUMI,
+    HISTORY_CHANNELS
+};
+
+#define HISTORY_INVALID 0xFFFF
+#define HISTORY_TIERS 3
+
+#define HISTORY_TIER0_LENGTH 600  // 10 min of 1 s samples
+#define HISTORY_TIER1_SECONDS 60
+#define HISTORY_TIER1_LENGTH 1440 // 24 h of 1 min buckets
+#define HISTORY_TIER2_SECONDS 3600
+#define HISTORY_TIER2_LENGTH 720  // 30 days of 1 h buckets
+
+// Checked at compile time against the size of the whole store
+#define HISTORY_BUDGET_BYTES (100 * 1024)
+
+struct history_bucket_t {
+    uint16_t min[HISTORY_CHANNELS];
+    uint16_t max[HISTORY_CHANNELS];
+    uint16_t mean[HISTORY_CHANNELS];
+};
+
+void historyAdd(const sample_t &sample);
+
+// One stored sample: seconds since boot plus every channel in raw ticks
+struct history_record_t {
+    uint32_t time;
+    uint16_t value[HISTORY_CHANNELS];
+};
+
+// A sample's values in channel order, HISTORY_INVALID where not valid
+void historyValues(const sample_t &sample, uint16_t value[HISTORY_CHANNELS]);
+
+// Buckets held in a tier, and the number of seconds each covers (tier 0:
+// the interval between the last two samples)
+uint16_t historyCount(uint8_t tier);
+uint32_t historyResolution(uint8_t tier);
+
+// Samples added since boot. Tier 0 point `age` is sample number
+// historySamples() - 1 - age, so this tells what came in since a given look.
+uint32_t historySamples();
+
+// Sample time from the first sample to the newest, in seconds (wrap-free,
+// unlike sample_t.time)
+uint32_t historySeconds();
+
+// Bucket `age` of a tier, 0 being the newest. Tier 0 points come back with
+// min = max = mean. Returns false if there is no such bucket.
+bool historyGet(uint8_t tier, uint16_t age, history_bucket_t &out);
+
+// Bytes of RAM used by the store
+uint32_t historySize();
@@ -0,0 +1,81 @@
+// enginair history_codec.h
+// Compression for stored history. Records are packed into a bit stream in
+// self-contained blocks: each block starts from a clean codec state, so any
+// block can be decoded on its own (random access per block), and a block
+// never grows past the buffer it was given.
+//
+// Per record, every channel is coded against its own previous value:
+//   time:       delta-of-delta, '0' for the usual steady 1 s step, then
+//               Gorilla-style size classes (7, 9, 12 or 32 bits)
+//   PM, CO2:    16-bit delta, zigzagged, '0' if zero, else '1' and a varint
+//               in 3-bit groups (4 bits per group with the continuation bit).
+//               PM1.0/4.0/10 are predicted to move with PM2.5, which the
+//               SEN5x derives them alongside, and code only the difference.
+//   T, RH:      XOR with the previous ticks (Gorilla, scaled down to 16 bits):
+//               '0' if unchanged, '10' + the bits inside the previous
+//               leading/trailing zero window, '11' + 4-bit leading zeros +
+//               4-bit length + the meaningful bits
+// The fields of a record are interleaved, so a block can be streamed out
+// without knowing its column sizes in advance.
+//
+// At 1 Hz a noisy PM trace comes to about 2.5 bytes per record (CO2, T and
+// RH only move every 5 s), against 20 bytes raw or 38 for the float layout
+// of the old Sensirion library; steady air codes smaller still.
+
+#pragma once
+
+#include <stdint.h>
+#include "history.h"
+
+// Worst case for one record: 4 + 32 time, 5 x (1 + 6 x 4) delta,
+// 2 x (2 + 4 + 4 + 16) XOR
+#define CODEC_MAX_RECORD_BITS (36 + 5 * 25 + 2 * 26)
+
+// State shared by both directions, so they evolve in lockstep
+struct codec_state_t {
+    uint32_t time;
+    int32_t timeDelta;
+    uint16_t value[HISTORY_CHANNELS];
+    uint8_t lead[HISTORY_CHANNELS];  // XOR window, XOR channels only
+    uint8_t trail[HISTORY_CHANNELS];
+};
+
+class HistoryEncoder {
+public:
+    // Start a new block in buffer (contents overwritten)
+    void begin(uint8_t *buffer, uint32_t size);
+
+    // Append a record. Returns false, without writing anything, once the
+    // block can't be guaranteed to hold another one.
+    bool add(const history_record_t &record);
+
+    uint32_t count() const { return _count; }
+    uint32_t bytes() const { return (_bit + 7) / 8; }
+
+private:
+    void put(uint32_t value, uint8_t bits);
+
+    uint8_t *_buffer;
+    uint32_t _size;
+    uint32_t _bit;
+    uint32_t _count;
+    codec_state_t _state;
+};
+
+class HistoryDecoder {
+public:
+    void begin(const uint8_t *buffer, uint32_t size);
+
+    // Next record of the block. The caller knows how many there are (the
+    // encoder's count()); running off the end of the data returns false.
+    bool next(history_record_t &record);
+
+private:
+    uint32_t get(uint8_t bits);
+
+    const uint8_t *_buffer;
+    uint32_t _size;
+    uint32_t _bit;
+    bool _overrun;
+    codec_state_t _state;
+};
@@ -0,0 +1,31 @@
+// enginair i2c_bus.h
+// The sensors and the OLED share one I2C bus (Wire, GP16/GP17) but are driven
+// from different cores, so every transaction is bracketed by this lock.
+// Part of the hardware abstraction (see hal.h): the native build simulates
+// the bus and the devices on it.
+
+#pragma once
+
+#include <stdint.h>
+
+#define I2C_SDA_PIN 16
+#define I2C_SCL_PIN 17
+#define I2C_SENSOR_CLOCK 100000  // SEN5x max is 100 kHz
+#define I2C_DISPLAY_CLOCK 400000 // SSD1306 fast mode
+
+void i2cBusInit();
+void i2cBusLock();
+void i2cBusUnlock();
+
+// One write transaction. Returns 0, or the Wire status code (2: address
+// NACK, 3: data NACK, 4: other error). Hold the bus lock.
+uint8_t i2cWrite(uint8_t address, const uint8_t *data, uint8_t length);
+
+// One read transaction. Returns the number of bytes read. Hold the bus lock.
+uint8_t i2cRead(uint8_t address, uint8_t *data, uint8_t length);
+
+// RAII helper: holds the bus for the enclosing scope
+struct I2CBusGuard {
+    I2CBusGuard() { i2cBusLock(); }
+    ~I2CBusGuard() { i2cBusUnlock(); }
+};
@@ -0,0 +1,65 @@
+// enginair oled.h
+// Non-blocking framebuffer flush for the SSD1306. Replaces
+// Adafruit_SSD1306::display(): the frame is diffed against what the panel
+// already shows, the changed column runs are expanded into an I2C command
+// stream, and that is handed to a DMA channel feeding the I2C0 TX FIFO, so
+// the CPU can draw the next frame while this one is on the wire. The I2C
+// bus is only held for one column run at a time, so sensor transactions on
+// the other core wait a few ms at most.
+
+#pragma once
+
+#include <stdint.h>
+
+#define OLED_ADDRESS 0x3C
+#define OLED_WIDTH 128
+#define OLED_HEIGHT 32
+#define OLED_PAGES (OLED_HEIGHT / 8)
+#define OLED_BUFFER_SIZE (OLED_WIDTH * OLED_PAGES)
+
+typedef void (*oled_done_fn_t)();
+
+// Claim a DMA channel and install the I2C0 interrupt. Call once, after the
+// display has been initialised through Adafruit_SSD1306::begin(). The
+// completion interrupt runs on the calling core.
+void oledBegin();
+
+// Queue a frame (Adafruit layout: one byte = 8 vertical pixels, page-major).
+// The frame is copied into one of two wire buffers, so the caller may start
+// drawing again as soon as this returns. If a transfer is already running,
+// the frame waits in the other wire buffer and replaces any frame that was
+// waiting there before. A frame identical to the panel is not sent at all.
+// Returns immediately.
+void oledFlushAsync(const uint8_t *buffer);
+
+// Blocking flush, for boot messages
+void oledFlush(const uint8_t *buffer);
+
+// Start the next column run of the frame on the wire, if the last one is
+// done. Takes the I2C bus, blocking while a sensor has it. Call from the
+// display core's loop; the flush functions call it too.
+void oledPoll();
+
+// Switch the panel off (display and charge pump: sleep mode, a few uA) or
+// back on. Its RAM keeps the last frame, so flushes carry on diffing
+// against it; frames sent while off show once it is on again. Waits for a
+// transfer in flight, then sends the commands directly.
+void oledSetPower(bool on);
+
+// True while a frame is on the wire or waiting for it
+bool oledBusy();
+
+// Called from the completion interrupt once the last frame has left the
+// FIFO and the bus is released. Keep it short.
+void oledOnFlushDone(oled_done_fn_t fn);
+
+// Frames sent, frames replaced before they reached the wire, frames skipped
+// because nothing changed, pixel bytes sent, and aborted transfers (NACK etc)
+struct oled_stats_t {
+    uint32_t frames;
+    uint32_t replaced;
+    uint32_t skipped;
+    uint32_t bytes;
+    uint32_t aborts;
+};
+oled_stats_t oledStats();
@@ -0,0 +1,171 @@
+// enginair page_fonts.h
+// The ArialMT fonts of OLEDDisplayFonts.h (ThingPulse/Meshtastic format),
+// converted to page_gfx.h fonts at compile time.
+//
+// The source format is nearly page layout already: a jump table of
+// (offset, byte count, advance) per character, then each glyph as columns
+// of (height + 7) / 8 bytes. But trailing zero bytes are cut off, so a
+// glyph's last column can be short. The conversion pads every column to
+// full height and builds the glyph table, all in constant expressions.
+// Only the characters in the given charset are emitted; the source tables
+// themselves are never odr-used, so none of them reaches flash.
+//
+// The cursor y is either the top of the glyph cell, as OLEDDisplay draws
+// them (OLED_FONT_TOP), or the baseline like GFX proportional fonts
+// (OLED_FONT_BASELINE), taken as the row under the lowest pixel of '0'.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "page_gfx.h"
+
+// Fonts available to the screens, charsets in page_fonts.cpp
+extern const page_font_t arialValueFont; // ArialMT_Plain_16, digits and "%-.", baseline
+extern const page_font_t arialSmallFont; // ArialMT_Plain_10, "pm", baseline
+extern const page_font_t arialLabelFont; // ArialMT_Plain_10, capitals of the labels, top
+extern const page_font_t arialDigitFont; // ArialMT_Plain_10, digits and ".-:", top
+
+namespace oledfont {
+
+#define OLED_FONT_HEADER 4 // width, height, first char, char count
+#define OLED_FONT_JUMP 4   // offset (big-endian), byte count, advance
+#define OLED_FONT_NO_BITMAP 0xFFFF
+
+enum anchor_t { OLED_FONT_TOP, OLED_FONT_BASELINE };
+
+constexpr uint8_t height(const uint8_t *font) { return font[1]; }
+constexpr uint8_t pages(const uint8_t *font) { return (font[1] + 7) / 8; }
+
+constexpr bool has(const uint8_t *font, uint8_t c) {
+    return c >= font[2] && c < font[2] + font[3];
+}
+
+constexpr const uint8_t *jump(const uint8_t *font, uint8_t c) {
+    return font + OLED_FONT_HEADER + (c - font[2]) * OLED_FONT_JUMP;
+}
+
+constexpr uint16_t offset(const uint8_t *font, uint8_t c) {
+    return (jump(font, c)[0] << 8) | jump(font, c)[1];
+}
+
+constexpr uint8_t advance(const uint8_t *font, uint8_t c) { return jump(font, c)[3]; }
+
+constexpr uint8_t columns(const uint8_t *font, uint8_t c) {
+    return offset(font, c) == OLED_FONT_NO_BITMAP ? 0 : (jump(font, c)[2] + pages(font) - 1) / pages(font);
+}
+
+constexpr const uint8_t *glyphData(const uint8_t *font, uint8_t c) {
+    return font + OLED_FONT_HEADER + font[3] * OLED_FONT_JUMP + offset(font, c);
+}
+
+constexpr bool wanted(const char *charset, uint8_t c) {
+    for (; *charset; charset++) {
+        if ((uint8_t)*charset == c) {
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr uint8_t rangeFirst(const char *charset) {
+    uint8_t first = 0xFF;
+    for (; *charset; charset++) {
+        first = (uint8_t)*charset < first ? (uint8_t)*charset : first;
+    }
+    return first;
+}
+
+constexpr uint8_t rangeLast(const char *charset) {
+    uint8_t last = 0;
+    for (; *charset; charset++) {
+        last = (uint8_t)*charset > last ? (uint8_t)*charset : last;
+    }
+    return last;
+}
+
+constexpr uint16_t span(const char *charset) {
+    return rangeLast(charset) - rangeFirst(charset) + 1;
+}
+
+// Bytes of padded column data for the charset
+constexpr size_t dataSize(const uint8_t *font, const char *charset) {
+    size_t size = 0;
+    for (uint16_t c = rangeFirst(charset); c <= rangeLast(charset); c++) {
+        if (wanted(charset, c) && has(font, c)) {
+            size += columns(font, c) * pages(font);
+        }
+    }
+    return size;
+}
+
+// Row under the lowest set pixel of '0'; the full height if there is none
+constexpr uint8_t baseline(const uint8_t *font) {
+    if (!has(font, '0') || columns(font, '0') == 0) {
+        return height(font);
+    }
+    uint8_t bottom = 0;
+    const uint8_t *data = glyphData(font, '0');
+    for (uint8_t i = 0; i < jump(font, '0')[2]; i++) {
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (data[i] & (1 << bit)) {
+                uint8_t row = (i % pages(font)) * 8 + bit + 1;
+                bottom = row > bottom ? row : bottom;
+            }
+        }
+    }
+    return bottom;
+}
+
+template <size_t N>
+struct FontData {
+    uint8_t bytes[N > 0 ? N : 1];
+};
+
+template <size_t N>
+constexpr FontData<N> convertData(const uint8_t *font, const char *charset) {
+    FontData<N> out{};
+    size_t o = 0;
+    for (uint16_t c = rangeFirst(charset); c <= rangeLast(charset); c++) {
+        if (!wanted(charset, c) || !has(font, c)) {
+            continue;
+        }
+        const uint8_t *data = glyphData(font, c);
+        uint8_t stored = columns(font, c) ? jump(font, c)[2] : 0;
+        for (size_t i = 0; i < stored; i++) {
+            out.bytes[o + i] = data[i];
+        }
+        o += columns(font, c) * pages(font); // the padding stays zero
+    }
+    return out;
+}
+
+// Glyph table over data from convertData(). Characters in the range but not
+// in the charset get empty glyphs, which draw nothing and don't advance.
+constexpr page_font_t convertTable(const uint8_t *font, const char *charset, anchor_t anchor,
+                                   const uint8_t *data) {
+    page_font_t out{};
+    out.first = rangeFirst(charset);
+    out.last = rangeLast(charset);
+    out.yAdvance = height(font);
+    int8_t yOffset = anchor == OLED_FONT_BASELINE ? -baseline(font) : 0;
+    size_t o = 0;
+    for (uint16_t c = out.first; c <= out.last; c++) {
+        if (!wanted(charset, c) || !has(font, c)) {
+            continue;
+        }
+        uint8_t width = columns(font, c);
+        out.glyphs[c - out.first] = {data + o, width, height(font), 0, yOffset, advance(font, c)};
+        o += width * pages(font);
+    }
+    return out;
+}
+
+} // namespace oledfont
+
+// Define name as the page font for charset out of an OLEDDisplayFonts.h table
+#define OLED_PAGE_FONT(name, font, charset, anchor)                                                \
+    static_assert(oledfont::span(charset) <= PAGE_FONT_MAX_GLYPHS, "charset spans too many chars"); \
+    static constexpr auto name##Data =                                                             \
+        oledfont::convertData<oledfont::dataSize(font, charset)>(font, charset);                   \
+    constexpr page_font_t name = oledfont::convertTable(font, charset, oledfont::anchor, name##Data.bytes)
@@ -0,0 +1,102 @@
+// enginair page_gfx.h
+// Drawing straight in the SSD1306 page layout (oled.h): one byte holds 8
+// vertical pixels, bit 0 on top. Fonts and icons are transposed into that
+// layout once, so drawing them is a shift and an OR per byte of glyph
+// instead of a drawPixel() call per set bit as in Adafruit GFX.
+//
+// For text that is redrawn at the same place every frame, a page_atlas_t
+// holds its glyphs already shifted to their row offset within the page, so
+// a character is a few byte runs ORed into the frame with no shifting.
+//
+// Text follows Adafruit GFX's rules exactly (cursor on the baseline for
+// proportional fonts, advance, wrap at the right edge), so a layout ported
+// from GFX calls renders pixel for pixel the same.
+
+#pragma once
+
+#include <stdint.h>
+#include "oled.h"
+
+// A bitmap in page layout: width columns of (height + 7) / 8 bytes each,
+// top byte first. Placed relative to a cursor, as a GFX glyph is.
+struct page_sprite_t {
+    const uint8_t *columns;
+    uint8_t width;
+    uint8_t height;
+    int8_t xOffset;   // cursor to left edge
+    int8_t yOffset;   // cursor to top edge
+    uint8_t xAdvance; // cursor step after drawing
+};
+
+// Glyphs for the characters first..last
+#define PAGE_FONT_MAX_GLYPHS 32
+struct page_font_t {
+    uint8_t first;
+    uint8_t last;
+    uint8_t yAdvance; // line step when text wraps
+    page_sprite_t glyphs[PAGE_FONT_MAX_GLYPHS];
+};
+
+struct page_cursor_t {
+    int16_t x;
+    int16_t y;
+};
+
+inline uint16_t pageSpriteSize(uint8_t width, uint8_t height) {
+    return width * ((height + 7) / 8);
+}
+
+// Transpose a row-major 1 bpp bitmap (MSB leftmost, each row rowBits bits
+// long, starting bitOffset bits into bits) into pageSpriteSize() bytes at
+// out. rowBits = width for GFX glyphs, a multiple of 8 for drawBitmap()
+// style icons.
+void pageTranspose(const uint8_t *bits, uint32_t bitOffset, uint16_t rowBits, uint8_t width,
+                   uint8_t height, uint8_t *out);
+
+// OR a sprite into frame at the cursor, clipped to the panel
+void pageBlit(uint8_t *frame, int16_t x, int16_t y, const page_sprite_t &sprite);
+
+// Draw text and advance the cursor. Characters outside the font are
+// skipped without advancing, as GFX does.
+void pageText(uint8_t *frame, const page_font_t &font, page_cursor_t &cursor, const char *text);
+
+// How far pageText() would move the cursor, if the text doesn't wrap
+int16_t pageTextWidth(const page_font_t &font, const char *text);
+
+// A sprite pre-shifted for one y: pages rows of width bytes each (row-major,
+// so each page is one contiguous run), starting at frame page topPage
+struct page_cached_t {
+    uint16_t offset; // into the atlas data
+    uint8_t width;   // 0: not cached
+    uint8_t pages;
+    int8_t topPage;  // may be -1 for sprites sticking out at the top
+    int8_t xOffset;
+};
+
+// Glyphs of a font pre-shifted for text on one baseline
+struct page_atlas_t {
+    const page_font_t *font;
+    int16_t y;
+    const uint8_t *data;
+    page_cached_t glyphs[PAGE_FONT_MAX_GLYPHS];
+};
+
+inline uint16_t pageCachedSize(const page_sprite_t &sprite, int16_t y) {
+    return sprite.width * ((((y + sprite.yOffset) & 7) + sprite.height + 7) / 8);
+}
+
+// Shift sprite for the cursor at y into pageCachedSize() bytes at out
+void pageCache(const page_sprite_t &sprite, int16_t y, uint8_t *out, page_cached_t &cached);
+
+// OR a cached sprite into frame at cursor x, clipped to the panel
+void pageBlitCached(uint8_t *frame, int16_t x, const uint8_t *data, const page_cached_t &cached);
+
+// Cache the glyphs of charset for text on baseline y, taking the bytes from
+// pool (advanced past them) up to poolEnd. Glyphs that don't fit stay
+// uncached; returns false if there were any.
+bool pageAtlasBuild(page_atlas_t &atlas, const page_font_t &font, int16_t y, const char *charset,
+                    uint8_t *&pool, const uint8_t *poolEnd);
+
+// pageText() through the atlas. Characters on another line (after a wrap,
+// or with the cursor elsewhere) or not cached are drawn by pageBlit().
+void pageAtlasText(uint8_t *frame, const page_atlas_t &atlas, page_cursor_t &cursor, const char *text);
@@ -0,0 +1,84 @@
+// enginair power.h
+// Power modes for battery units, and an estimate of what each part of the
+// board draws.
+//
+// POWER_NORMAL is the mains setup: a sample every second, both sensors
+// measuring all the time, the display always on. POWER_LOW trades latency
+// for current:
+//   - the sample clock ticks every period seconds
+//   - the SEN50 idles (fan and laser off) between samples and starts
+//     measuring warmup seconds before each one, so the reading has settled
+//   - the SCD40 runs low power periodic measurement, a reading every ~30 s
+//   - the display goes off displayTimeout seconds after the last console
+//     command, and comes back on with the next one
+//   - each PM reading stands for the whole period in the AQI means (aqi.h),
+//     which would otherwise lose every minute without a reading; at long
+//     periods the indices rest on few readings (one an hour at the most)
+// In both modes the cores sleep (WFE) whenever they have nothing to do and
+// the sample alarm wakes them. Dormant mode is not used: it stops the
+// oscillators, and with them the timer the alarm runs on.
+//
+// Each component's time in its active state is tallied (for the cores:
+// time awake), which gives its duty cycle, and with typical datasheet
+// currents for both states an estimate of its average draw. Each component
+// is updated from the core that owns it; totals are read from either.
+
+#pragma once
+
+#include <stdint.h>
+
+enum power_mode_t {
+    POWER_NORMAL,
+    POWER_LOW
+};
+
+#define POWER_LOW_PERIOD_S 60       // default period in POWER_LOW
+#define POWER_WARMUP_S 30           // SEN50 measuring time before each sample
+#define POWER_DISPLAY_TIMEOUT_S 60
+#define POWER_MAX_PERIOD_S 3600
+#define POWER_IDLE_MIN_S 2          // SEN50 stop and start take ~0.25 s, shorter idles don't pay
+
+struct power_config_t {
+    power_mode_t mode;
+    uint16_t period;         // s between samples in POWER_LOW (POWER_NORMAL: 1)
+    uint16_t warmup;         // s
+    uint16_t displayTimeout; // s after the last command, 0: never off
+};
+
+// Sample clock period in us
+uint32_t powerSamplePeriodUs(const power_config_t &config);
+
+// The SEN50 idles between samples: POWER_LOW, and enough of the period left
+// after the warmup
+bool powerPmDutyCycled(const power_config_t &config);
+
+enum power_component_t {
+    POWER_CORE0, // awake (not in WFE)
+    POWER_CORE1,
+    POWER_SEN50, // measuring, vs idle mode
+    POWER_SCD40, // periodic, vs low power periodic measurement
+    POWER_OLED,  // display on, vs off
+    POWER_COMPONENTS
+};
+
+// Component state changes (SEN50, SCD40, OLED)
+void powerSetActive(power_component_t component, bool active);
+
+// Time a core spent awake
+void powerAddActive(power_component_t component, uint32_t us);
+
+// Active time of every component since boot, up to when it was taken.
+// Two of these bracket the interval a report covers.
+struct power_usage_t {
+    uint64_t time;
+    uint64_t active[POWER_COMPONENTS];
+};
+power_usage_t powerUsage();
+
+const char *powerComponentName(power_component_t component);
+
+// Over the interval from..to: time active in 0.1%, and estimated average
+// supply current in uA
+uint16_t powerDuty(const power_usage_t &from, const power_usage_t &to, power_component_t component);
+uint32_t powerAverageUa(const power_usage_t &from, const power_usage_t &to,
+                        power_component_t component);
@@ -0,0 +1,71 @@
+// enginair profile.h
+// Always-on latency histograms for the stages of the sample path. Each
+// stage times itself with the cycle counter and feeds a log-bucketed
+// histogram (4 buckets per power of two, so percentiles are within 25%),
+// plus a count of runs over the stage's budget. Recording is a handful of
+// integer ops; at the ~20 recordings per second the loops make, that is far
+// below 0.1% of a 133 MHz core (see "profile record" in bench.cpp).
+//
+// Every stage is recorded from one core only (the flush from the OLED
+// interrupt), so no locking is needed. Most stages time a piece of work;
+// ALARM and START are the lateness of the sample timebase, i.e. its jitter.
+// Readers on the other core may see a histogram mid-update, which is fine
+// for a diagnostic dump.
+
+#pragma once
+
+#include <stdint.h>
+#include "hal.h"
+
+enum profile_stage_t {
+    PROFILE_SEN50,  // core 0: SEN50 command issue, or poll() that did something
+    PROFILE_SCD40,  // core 0: SCD40 data ready check/read issue, or poll()
+    PROFILE_STORE,  // core 1: history and flash log
+    PROFILE_DRAW,   // core 1: drawing a frame and handing it to oled.h
+    PROFILE_FLUSH,  // OLED interrupt: frame on the wire, start to STOP
+    PROFILE_OUTPUT, // core 1: serial text or telemetry frame
+    PROFILE_ALARM,  // core 0: sample alarm deadline to its interrupt (sample_clock.h)
+    PROFILE_START,  // core 0: sample alarm deadline to the SEN50 read going out
+    PROFILE_STAGES
+};
+
+#define PROFILE_SUB_BITS 2
+#define PROFILE_BUCKETS ((32 - PROFILE_SUB_BITS + 1) << PROFILE_SUB_BITS)
+
+struct profile_summary_t {
+    uint32_t count;
+    uint32_t overruns; // runs longer than the stage budget
+    uint32_t min;      // all in cycles
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+    uint64_t total;
+};
+
+void profileRecord(profile_stage_t stage, uint32_t cycles);
+
+static inline uint32_t profileStart() {
+    return halCycles();
+}
+
+static inline void profileEnd(profile_stage_t stage, uint32_t start) {
+    profileRecord(stage, halCycles() - start);
+}
+
+// For stages that have to be timed with halMicros(), e.g. across cores
+void profileRecordMicros(profile_stage_t stage, uint32_t us);
+
+const char *profileStageName(profile_stage_t stage);
+uint32_t profileBudgetUs(profile_stage_t stage);
+
+// false if the stage has no recordings since the last reset
+bool profileSummary(profile_stage_t stage, profile_summary_t &out);
+
+// Raw histogram. Bucket i covers [profileBucketLow(i), profileBucketLow(i + 1))
+// cycles.
+uint32_t profileBucketCount(profile_stage_t stage, uint8_t bucket);
+uint32_t profileBucketLow(uint8_t bucket);
+
+// Clear every stage. Safe from either core: each stage is cleared by its
+// own recorder the next time it records.
+void profileReset();
@@ -0,0 +1,33 @@
+// enginair ring.h
+// Fixed-size ring buffer that overwrites its oldest entry when full.
+// Single-core use only (see spsc_queue.h for the cross-core queue).
+
+#pragma once
+
+#include <stdint.h>
+
+template <typename T, uint16_t N>
+class Ring {
+public:
+    void push(const T &item) {
+        _items[_head] = item;
+        _head = (_head + 1) % N;
+        if (_count < N) {
+            _count++;
+        }
+    }
+
+    // age 0 is the newest entry; age must be < count()
+    const T &get(uint16_t age) const {
+        return _items[(_head + N - 1 - age) % N];
+    }
+
+    uint16_t count() const { return _count; }
+    static constexpr uint16_t capacity() { return N; }
+    void clear() { _head = 0; _count = 0; }
+
+private:
+    T _items[N];
+    uint16_t _head = 0;
+    uint16_t _count = 0;
+};
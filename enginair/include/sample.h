@@ -0,0 +1,39 @@
+// enginair sample.h
+// One snapshot of all sensor readings, handed from the acquisition core to
+// the rendering core. Values stay in the sensors' own integer encodings all
+// the way through; the RP2040 has no FPU, so nothing here is a float.
+
+#pragma once
+
+#include <stdint.h>
+#include "stats.h"
+#include "aqi.h"
+
+// sample_t.flags
+#define SAMPLE_PM_VALID  0x01 // SEN50 read succeeded this tick
+#define SAMPLE_CO2_VALID 0x02 // SCD40 has produced at least one reading
+#define SAMPLE_CO2_NEW   0x04 // SCD40 reading is fresh this tick
+#define SAMPLE_PREVIEW   0x08 // off the tick grid, for the display only (first readings at boot)
+
+#define SEN5X_PM_INVALID 0xFFFF // SEN5x reports this until the first reading
+
+struct sample_t {
+    uint32_t time; // tick deadline, micros()
+    uint16_t pm1p0, pm2p5, pm4p0, pm10p0; // SEN5x ticks, 0.1 ug/m3
+    uint16_t co2;  // ppm
+    uint16_t temp; // SCD4x ticks, T = -45 + 175 * ticks / 2^16 degC
+    uint16_t humi; // SCD4x ticks, RH = 100 * ticks / 2^16 %
+    uint8_t flags;
+    stats_summary_t pm2p5Stats; // smoothed PM2.5, kept by core 0 (stats.h)
+    aqi_t aqi;                  // kept by core 0 (aqi.h)
+};
+
+// SCD4x ticks to tenths of a degree C, rounded (datasheet formula, integer only)
+static inline int16_t scd4xTempTenths(uint16_t ticks) {
+    return -450 + (int16_t)((1750u * ticks + 0x8000u) >> 16);
+}
+
+// SCD4x ticks to tenths of a percent RH, rounded
+static inline uint16_t scd4xHumiTenths(uint16_t ticks) {
+    return (uint16_t)((1000u * ticks + 0x8000u) >> 16);
+}
@@ -0,0 +1,32 @@
+// enginair sample_clock.h
+// The sample timebase. A hardware alarm (hal.h) fires every period and the
+// interrupt only latches the timer and counts the tick; the acquisition
+// loop on core 0 takes the tick and starts the sensor reads from there. No
+// I2C happens in the interrupt, so the sample instants stay evenly spaced
+// however long reads, prints or the loop's own work take; only the command
+// issue lags behind, and that lag is measured (PROFILE_START in profile.h)
+// next to the interrupt latency (PROFILE_ALARM).
+
+#pragma once
+
+#include <stdint.h>
+
+struct sample_tick_t {
+    uint32_t due;  // deadline of the tick (first + n * period)
+    uint32_t time; // timer value when the interrupt ran: the sample's timestamp
+};
+
+struct sample_clock_stats_t {
+    uint32_t period; // us
+    uint32_t ticks;  // alarms fired
+    uint32_t missed; // ticks superseded by a newer one before they were taken
+};
+
+// Start ticking at first (micros), then every period
+void sampleClockStart(uint32_t first, uint32_t period);
+
+// The newest tick not yet taken. false if there is none. Call from the core
+// that started the clock.
+bool sampleClockTake(sample_tick_t &tick);
+
+sample_clock_stats_t sampleClockStats();
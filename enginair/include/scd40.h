@@ -0,0 +1,51 @@
+// enginair scd40.h
+// Non-blocking SCD40 driver. Every operation is a state machine advanced by
+// poll(): commands are issued, and their results fetched on a later call once
+// the sensor's execution time has passed. Nothing here ever sleeps.
+
+#pragma once
+
+#include <stdint.h>
+#include "sensirion.h"
+
+#define SCD40_ADDRESS 0x62
+
+class Scd40 {
+public:
+    // Stop any measurement left running from a previous boot (or in the
+    // other mode), then start periodic measurement: one reading every 5 s,
+    // or with lowPower, low power periodic measurement, one every 30 s
+    void begin(bool lowPower = false);
+    void reset() { begin(low); }
+
+    // Check the data-ready flag and read the measurement if there is one.
+    // With direct, skip the flag and read straight away; the sensor NACKs
+    // the read if there is no new data, which is reported as
+    // DRIVER_NOT_READY. The outcome is reported by a later poll().
+    void requestRead(bool direct = false);
+
+    driver_event_t poll(uint32_t now);
+
+    bool measuring() const { return state >= MEASURING; }
+    bool busy() const { return state != MEASURING && state != OFF; }
+    bool lowPower() const { return low; }
+
+    // Last reading (DRIVER_SAMPLE), in sensor ticks, see sample.h
+    uint16_t co2, temp, humi;
+
+    // Last failure (DRIVER_ERROR)
+    uint16_t error;
+    const char *errorContext;
+
+private:
+    enum state_t { OFF, STOPPING, STARTING, MEASURING, CHECKING, READING };
+
+    driver_event_t fail(uint16_t err, const char *context, state_t next);
+
+    sensirion_dev_t dev = {SCD40_ADDRESS, 0, 0, 0};
+    state_t state = OFF;
+    bool readRequested = false;
+    bool readDirect = false;
+    bool low = false; // low power periodic measurement
+    uint16_t pendingError = 0; // from the stop issued by begin()
+};
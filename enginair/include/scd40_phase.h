@@ -0,0 +1,70 @@
+// enginair scd40_phase.h
+// Predictive read scheduling for the SCD40. The sensor produces a sample
+// every ~5 s (~30 s in low power periodic mode) on its own clock. Once we
+// have seen one arrive, we know its phase, so instead of polling the
+// data-ready flag we read directly just after each expected completion. A
+// failed direct read means the prediction drifted, and we fall back to
+// polling until we lock on again. Every so often the phase is re-measured
+// (a short burst of flag polls just before the prediction) to refine the
+// period estimate.
+
+#pragma once
+
+#include <stdint.h>
+
+#define SCD40_PERIOD_US 5000000      // nominal measurement interval
+#define SCD40_LOW_POWER_PERIOD_US 30000000 // the same in low power periodic mode
+#define SCD40_READ_MARGIN_US 30000   // read this long after the predicted completion
+#define SCD40_POLL_US 100000         // flag polling interval while unlocked
+#define SCD40_PROBE_US 25000         // flag polling interval while re-measuring
+#define SCD40_PROBE_LEAD_US 150000   // start re-measuring this long before the prediction
+#define SCD40_PROBE_EVERY 12         // re-measure every this many samples (~1 min, low power ~6)
+#define SCD40_PERIOD_TOLERANCE 20    // accept period estimates within +-1/20 (5%) of nominal
+
+// Commands sent vs the old scheme (flag check every second + one read per
+// sample). One command is a write plus a read transaction on the bus.
+struct scd40_bus_stats_t {
+    uint32_t checks;  // data-ready commands
+    uint32_t reads;   // read_measurement commands
+    uint32_t samples; // readings received
+    uint32_t misses;  // direct reads that found no data (lost lock)
+    uint32_t probes;  // phase re-measurements
+    uint32_t baseline;// commands the old scheme would have sent by now
+    uint32_t saved;   // baseline - (checks + reads)
+    uint32_t period;  // current period estimate, us
+};
+
+class Scd40Phase {
+public:
+    // Start (or restart) from polling, for a sensor measuring every nominal us
+    void begin(uint32_t now, uint32_t nominal = SCD40_PERIOD_US);
+
+    // The read task is running: should it read directly (true) or check the
+    // data-ready flag (false)? Counts the command.
+    bool nextRequest();
+
+    // Outcome of the request. Each returns the time the read task should
+    // next run.
+    uint32_t onSample(uint32_t now);
+    uint32_t onNotReady(uint32_t now);
+
+    scd40_bus_stats_t stats(uint32_t now) const;
+
+private:
+    enum mode_t { POLLING, LOCKED, PROBING };
+
+    void measurePeriod(uint32_t now);
+
+    mode_t mode = POLLING;
+    bool direct = false;      // what nextRequest() last asked for
+    uint32_t predicted = 0;   // expected completion of the next sample
+    uint32_t nominal = SCD40_PERIOD_US;
+    uint32_t period = SCD40_PERIOD_US;
+    uint32_t anchor = 0;      // completion time we first locked on at
+    bool haveAnchor = false;
+    uint32_t sinceAnchor = 0; // samples since anchor
+    uint8_t sinceProbe = 0;
+    uint8_t probeChecks = 0;  // flag checks since the probe started
+    uint32_t startTime = 0;
+    scd40_bus_stats_t counts = {};
+};
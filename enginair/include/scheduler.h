@@ -0,0 +1,49 @@
+// enginair scheduler.h
+// Small cooperative scheduler. Each task has a fixed period and an absolute
+// deadline on the micros() timebase; deadlines advance by whole periods so the
+// schedule never drifts, no matter how long the task itself took.
+
+#pragma once
+
+#include <stdint.h>
+
+typedef void (*task_fn_t)();
+
+struct task_t {
+    const char *name;
+    task_fn_t fn;
+    uint32_t period_us;
+    uint32_t offset_us;  // phase relative to schedulerStart()
+    uint32_t deadline;   // next absolute deadline (micros)
+    uint32_t overruns;   // whole periods skipped because we ran late
+    bool stopped;        // see schedulerStopCurrent()
+};
+
+// Arm every task: first deadline is now + its offset.
+void schedulerStart(task_t *tasks, uint8_t count);
+
+// Run every task that is due (in table order). Call from loop().
+void schedulerRun();
+
+// WFE until the next task deadline or wake time. Call at the end of loop(),
+// once any work kicked off by the tasks has been started.
+void schedulerIdle();
+
+// Also wake up at t (micros), e.g. when a sensor command finishes. One-shot.
+// Up to SCHEDULER_MAX_WAKES can be outstanding; beyond that the latest ones
+// are dropped.
+#define SCHEDULER_MAX_WAKES 4
+void schedulerWakeAt(uint32_t t);
+
+// Stop the task currently running; it won't be run again. For one-off
+// phases such as boot.
+void schedulerStopCurrent();
+
+// Move a task's next deadline to t (micros), for tasks whose timing is
+// decided by events rather than a fixed period. Its period applies again
+// after that run. A stopped task runs again.
+void schedulerSetDeadline(task_t &task, uint32_t t);
+
+// Deadline of the task currently running, i.e. the jitter-free timestamp of
+// this tick. Only meaningful inside a task.
+uint32_t schedulerTickTime();
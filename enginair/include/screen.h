@@ -0,0 +1,57 @@
+// enginair screen.h
+// What goes on the OLED. Drawing happens on core 1 (initDisplay and the
+// boot message excepted) and is handed to oled.h to flush.
+
+#pragma once
+
+#include <stdint.h>
+#include "aqi.h"
+
+#define PROJECT_NAME "enginAIR"
+#define NO_VALUE "--" // drawn for values that don't exist yet
+
+enum message_t {
+    DEBUG,
+    NAME,
+    INFO,
+    WARN,
+    ERR
+};
+
+bool initDisplay();
+void showMessage(const char *message, message_t level);
+// PM, temperature and humidity arguments are fixed-point tenths (123 = 12.3).
+// flags (SAMPLE_*) say which values exist yet; missing ones are drawn as "--".
+// The detail screens only draw their values: labels, icons and separators
+// are rendered once at init into a layer per screen that each frame starts
+// from, so moving between screens costs no more than staying on one.
+void showPMValues(uint16_t pm1p0, uint16_t pm2p5, uint16_t pm4p0, uint16_t pm10p0, uint8_t flags);
+void showCO2Values(uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags);
+void showAQIValues(const aqi_t &aqi);
+void showValues_LargeText(uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags);
+
+// Device health for the stats screen
+struct screen_stats_t {
+    uint32_t uptime;  // seconds
+    uint32_t boot;    // power-up number (flash log)
+    uint32_t records; // samples in the flash log, with the RAM batch
+    uint32_t dropped; // samples lost between the cores
+};
+void showStats(const screen_stats_t &stats);
+
+// Trend of the last seconds of history.h: PM2.5 over the top half, CO2
+// below, each with its newest value on the left. Call once per sample; a
+// frame only draws (and the flush only sends) what the new sample changes.
+//   TREND_SCROLL  the trace moves left, newest on the right edge. The panel
+//                 has no one-step scroll, so every column whose pixels
+//                 differ from its right neighbour's goes on the wire again.
+//   TREND_SWEEP   the trace stands still and a gap sweeps across it,
+//                 newest point just left of the gap: two columns per sample.
+enum trend_mode_t {
+    TREND_SCROLL,
+    TREND_SWEEP
+};
+void showTrend(trend_mode_t mode);
+
+// Bench build: cycles per frame of the value screen renderer(s), see bench.h
+void screenBench();
@@ -0,0 +1,46 @@
+// enginair screen_page.h
+// The screens of screen.h drawn with page_gfx.h. The layout is shared by
+// both builds. The fonts are the ArialMT ones of page_fonts.h; screenBench()
+// swaps in the Adafruit GFX fonts of the old renderer to compare the two.
+//
+// The value text only ever sits on two baselines, so its glyphs (and the
+// degree icon) are kept pre-shifted for those in a page_atlas_t, and a
+// frame is built from byte runs (see "frame page" in screenBench()).
+//
+// The detail screens start each frame from a copy of their static layer
+// (labels, icons, separators), rendered by screenPageBegin(), and only draw
+// their values on top.
+
+#pragma once
+
+#include <stdint.h>
+#include "page_gfx.h"
+#include "screen.h"
+
+// Set the fonts and render their glyphs for the layout into the atlas.
+// Both are drawn with the cursor on the baseline; value must cover
+// SCREEN_VALUE_CHARSET, small SCREEN_SMALL_CHARSET. false if the atlas is
+// too small for them, which only costs speed.
+#define SCREEN_VALUE_CHARSET "0123456789.-%"
+#define SCREEN_SMALL_CHARSET "pm"
+bool screenPageFonts(const page_font_t *value, const page_font_t *small);
+
+// Transpose the icons, set the ArialMT fonts and render the static layers.
+// Call once.
+void screenPageBegin();
+
+// showValues_LargeText() into frame, which is cleared first
+void screenDrawValues(uint8_t *frame, uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi,
+                      uint8_t flags);
+
+// showPMValues(), showCO2Values(), showStats() and showAQIValues() into
+// frame, which is overwritten with the screen's layer first
+void screenDrawPM(uint8_t *frame, uint16_t pm2p5, uint16_t pm10p0, uint8_t flags);
+void screenDrawClimate(uint8_t *frame, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags);
+void screenDrawStats(uint8_t *frame, const screen_stats_t &stats);
+void screenDrawAQI(uint8_t *frame, const aqi_t &aqi);
+
+// showTrend() into frame. onScreen: frame still holds the trend as the last
+// call left it, so only the samples since then need drawing (if it was one;
+// otherwise, or if not onScreen, the whole screen is redrawn).
+void screenDrawTrend(uint8_t *frame, trend_mode_t mode, bool onScreen);
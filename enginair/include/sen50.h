@@ -0,0 +1,53 @@
+// enginair sen50.h
+// Non-blocking SEN50 driver, same shape as the SCD40 one (scd40.h): commands
+// are issued by one poll() and their results picked up by a later one.
+
+#pragma once
+
+#include <stdint.h>
+#include "sensirion.h"
+
+#define SEN50_ADDRESS 0x69
+
+class Sen50 {
+public:
+    // Reset the sensor, then start measurement
+    void begin();
+    void reset() { begin(); }
+
+    // Idle mode (fan and laser off) and back. stopMeasurement() only acts
+    // while measuring and drops any pending read; startMeasurement() only
+    // from idle, and reports DRIVER_STARTED again once measuring. The first
+    // readings after a start are invalid or unsettled (see power.h).
+    void stopMeasurement();
+    void startMeasurement();
+
+    // Read the measured values; the outcome is reported by a later poll().
+    // With ifReady, check the data-ready flag first and report
+    // DRIVER_NOT_READY instead of reading stale/invalid values.
+    void requestRead(bool ifReady = false);
+
+    driver_event_t poll(uint32_t now);
+
+    bool measuring() const { return state >= MEASURING; }
+    bool busy() const { return state != MEASURING && state != OFF && state != IDLE; }
+
+    // Last reading (DRIVER_SAMPLE), SEN5x ticks of 0.1 ug/m3
+    uint16_t pm1p0, pm2p5, pm4p0, pm10p0;
+
+    // Last failure (DRIVER_ERROR)
+    uint16_t error;
+    const char *errorContext;
+
+private:
+    enum state_t { OFF, IDLE, RESETTING, STOPPING, STARTING, MEASURING, CHECKING, READING };
+
+    driver_event_t fail(uint16_t err, const char *context, state_t next);
+
+    sensirion_dev_t dev = {SEN50_ADDRESS, 0, 0, 0};
+    state_t state = OFF;
+    bool readRequested = false;
+    bool checkReady = false;
+    uint16_t pendingError = 0; // from a command issued outside poll()
+    const char *pendingContext = nullptr;
+};
@@ -0,0 +1,52 @@
+// enginair sensirion.h
+// Minimal Sensirion I2C protocol: 16-bit commands, 16-bit words each followed
+// by a CRC-8. Commands are split into "issue" and "fetch" halves so the
+// caller never sleeps through a command's execution time.
+
+#pragma once
+
+#include <stdint.h>
+
+// Error codes. The low byte is the kind, the high byte carries the Wire
+// status for write errors.
+#define SENSIRION_OK 0
+#define SENSIRION_ERR_WRITE 1 // NACK or bus error while sending
+#define SENSIRION_ERR_READ 2  // device returned fewer bytes than asked
+#define SENSIRION_ERR_CRC 3   // word failed its checksum
+#define SENSIRION_ERR_BUSY 4  // previous command still executing
+
+#define SENSIRION_MAX_WORDS 9
+#define SENSIRION_MAX_ARGS 4
+
+// What a driver's poll() has to report
+enum driver_event_t {
+    DRIVER_NONE,      // nothing happened (or still waiting on the sensor)
+    DRIVER_STARTED,   // boot/reset sequence finished, sensor is measuring
+    DRIVER_SAMPLE,    // a new reading is available
+    DRIVER_NOT_READY, // a read was requested but the sensor had no new data
+    DRIVER_ERROR,     // see the driver's error/errorContext
+};
+
+struct sensirion_dev_t {
+    uint8_t address;
+    uint16_t command;  // in flight, 0 if none
+    uint8_t words;     // words to fetch once it is done
+    uint32_t readyAt;  // micros() when the result can be fetched
+};
+
+uint8_t sensirionCrc(const uint8_t *data, uint8_t len);
+
+// Send cmd plus up to SENSIRION_MAX_ARGS argument words. The device needs
+// execUs before it can be addressed again; readyAt is set accordingly.
+uint16_t sensirionIssue(sensirion_dev_t &dev, uint16_t cmd, uint32_t execUs, uint8_t words = 0,
+                        const uint16_t *args = nullptr, uint8_t nargs = 0);
+
+// Has the command in flight finished executing?
+bool sensirionDone(const sensirion_dev_t &dev, uint32_t now);
+
+// Read the result words of the finished command (none for write-only
+// commands) and clear it. Call only once sensirionDone() is true.
+uint16_t sensirionFetch(sensirion_dev_t &dev, uint16_t *out);
+
+// Human-readable error, for the serial log
+const char *sensirionErrorString(uint16_t error);
@@ -0,0 +1,50 @@
+// enginair spsc_queue.h
+// Lock-free single-producer/single-consumer ring buffer, safe to share
+// between the two RP2040 cores. N must be a power of two.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscQueue {
+    static_assert(N && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    // Producer side. Returns false (and counts a drop) if the queue is full,
+    // so the producer never waits on the consumer.
+    bool push(const T &item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) {
+            _dropped++;
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if there is nothing to pop.
+    bool pop(T &item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+        item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t count() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0}; // written by producer only
+    std::atomic<uint32_t> _tail{0}; // written by consumer only
+    uint32_t _dropped = 0;          // producer only
+};
@@ -0,0 +1,244 @@
+// enginair stats.h
+// Streaming statistics over one channel, updated per sample in constant
+// (or, for the median, small and bounded) time:
+//   Ewma<SHIFT>          exponentially weighted mean, alpha = 2^-SHIFT
+//   MinMaxWindow<N>      min and max of the last N samples (monotonic deques)
+//   PercentileWindow<N>  any percentile of the last N samples (sorted window)
+// StreamStats bundles the set the firmware keeps for PM2.5 into a
+// stats_summary_t that travels with each sample (sample.h).
+//
+// All integer, values in sensor ticks like everything else in sample_t.
+// Window sizes are template parameters, so the storage is static.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Exponentially weighted moving average. Time constant is about 2^SHIFT
+// samples. The state keeps EWMA_FRACTION_BITS below the tick, so slow
+// averages don't get stuck a few ticks short of a step.
+#define EWMA_FRACTION_BITS 12
+
+template <uint8_t SHIFT>
+class Ewma {
+    static_assert(SHIFT > 0 && SHIFT <= 16, "Ewma shift out of range");
+
+public:
+    void push(uint16_t value) {
+        int32_t x = (int32_t)value << EWMA_FRACTION_BITS;
+        if (!_started) {
+            _state = x; // seed with the first sample rather than ramp up from 0
+            _started = true;
+            return;
+        }
+        _state += (x - _state) >> SHIFT; // arithmetic shift: rounds toward -inf
+    }
+
+    uint16_t value() const {
+        return (uint16_t)((_state + (1 << (EWMA_FRACTION_BITS - 1))) >> EWMA_FRACTION_BITS);
+    }
+
+    void clear() { _started = false; }
+
+private:
+    int32_t _state = 0;
+    bool _started = false;
+};
+
+// Sliding-window min and max. Each deque holds the samples that can still
+// become the extreme: for the max, a strictly decreasing run (anything
+// smaller than a newer sample never will). Every sample enters and leaves
+// each deque once, so push() is O(1) amortised, min()/max() O(1).
+template <uint16_t N>
+class MinMaxWindow {
+public:
+    void push(uint16_t value) {
+        uint32_t index = _next++;
+        _max.expire(index);
+        _min.expire(index);
+        _max.push(value, index, [](uint16_t back, uint16_t v) { return back <= v; });
+        _min.push(value, index, [](uint16_t back, uint16_t v) { return back >= v; });
+    }
+
+    // Only valid once something was pushed. (Not min()/max(): Arduino.h
+    // may define macros by those names.)
+    uint16_t minimum() const { return _min.front(); }
+    uint16_t maximum() const { return _max.front(); }
+
+    void clear() {
+        _min.clear();
+        _max.clear();
+    }
+
+private:
+    struct Deque {
+        uint16_t value[N];
+        uint32_t index[N]; // sample number, to expire the front
+        uint16_t head = 0;
+        uint16_t count = 0;
+
+        template <typename Dominated>
+        void push(uint16_t v, uint32_t i, Dominated dominated) {
+            while (count && dominated(value[(head + count - 1) % N], v)) {
+                count--;
+            }
+            uint16_t slot = (head + count) % N;
+            value[slot] = v;
+            index[slot] = i;
+            count++;
+        }
+
+        // Drop the front if it falls out of the window ending at newest, which
+        // leaves room for newest even if the deque was full
+        void expire(uint32_t newest) {
+            if (count && newest - index[head] >= N) {
+                head = (head + 1) % N;
+                count--;
+            }
+        }
+
+        uint16_t front() const { return value[head]; }
+        void clear() { head = count = 0; }
+    };
+
+    Deque _min;
+    Deque _max;
+    uint32_t _next = 0;
+};
+
+// Sliding-window percentiles: the window kept twice, in arrival order (to
+// know what drops out) and sorted. A push is two binary searches and one
+// memmove of the values between the leaving and the arriving sample, at
+// most N - 1 of them; a percentile is a lookup.
+template <uint16_t N>
+class PercentileWindow {
+public:
+    void push(uint16_t value) {
+        // Hole left by the oldest sample, or a new slot at the end
+        uint16_t from = _count == N ? lowerBound(_arrival[_head]) : _count;
+        uint16_t to = lowerBound(value);
+        if (_count < N) {
+            _count++;
+        }
+        _arrival[_head] = value;
+        _head = (_head + 1) % N;
+
+        // Close the hole towards the new value's place and put it there
+        if (to > from) {
+            to--; // the stale value in the hole was counted by lowerBound()
+            memmove(_sorted + from, _sorted + from + 1, (to - from) * sizeof(uint16_t));
+        } else {
+            memmove(_sorted + to + 1, _sorted + to, (from - to) * sizeof(uint16_t));
+        }
+        _sorted[to] = value;
+    }
+
+    // Percentile (0..100) of the window: the sample at that rank, rounded to
+    // the nearest. Only valid once something was pushed.
+    uint16_t percentile(uint8_t percent) const {
+        return _sorted[((uint32_t)(_count - 1) * percent + 50) / 100];
+    }
+
+    uint16_t median() const { return percentile(50); }
+    uint16_t count() const { return _count; }
+    void clear() { _head = _count = 0; }
+
+private:
+    // First position in _sorted[0.._count) not below value
+    uint16_t lowerBound(uint16_t value) const {
+        uint16_t lo = 0;
+        uint16_t hi = _count;
+        while (lo < hi) {
+            uint16_t mid = (lo + hi) / 2;
+            if (_sorted[mid] < value) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    uint16_t _arrival[N];
+    uint16_t _sorted[N];
+    uint16_t _head = 0;
+    uint16_t _count = 0;
+};
+
+// What StreamStats keeps. The sizes count samples, so the times hold at
+// 1 sample per second; at the POWER_LOW period (power.h) they stretch by
+// the same factor, e.g. the 5 min window spans 5 h at one sample a minute.
+#define STATS_FAST_SHIFT 3     // EWMA, ~8 s
+#define STATS_MID_SHIFT 6      // ~1 min
+#define STATS_SLOW_SHIFT 8     // ~4 min
+#define STATS_MINMAX_WINDOW 300 // 5 min
+#define STATS_MEDIAN_WINDOW 60  // 1 min
+#define STATS_PERCENTILE 90
+
+struct stats_summary_t {
+    uint16_t count; // samples in the median window; 0: nothing yet
+    uint16_t fast, mid, slow;
+    uint16_t min, max;
+    uint16_t median, p90;
+};
+
+class StreamStats {
+public:
+    void push(uint16_t value) {
+        _fast.push(value);
+        _mid.push(value);
+        _slow.push(value);
+        _extremes.push(value);
+        _window.push(value);
+    }
+
+    void clear() {
+        _fast.clear();
+        _mid.clear();
+        _slow.clear();
+        _extremes.clear();
+        _window.clear();
+    }
+
+    stats_summary_t summary() const {
+        stats_summary_t s = {};
+        s.count = _window.count();
+        if (s.count == 0) {
+            return s;
+        }
+        s.fast = _fast.value();
+        s.mid = _mid.value();
+        s.slow = _slow.value();
+        s.min = _extremes.minimum();
+        s.max = _extremes.maximum();
+        s.median = _window.median();
+        s.p90 = _window.percentile(STATS_PERCENTILE);
+        return s;
+    }
+
+private:
+    Ewma<STATS_FAST_SHIFT> _fast;
+    Ewma<STATS_MID_SHIFT> _mid;
+    Ewma<STATS_SLOW_SHIFT> _slow;
+    MinMaxWindow<STATS_MINMAX_WINDOW> _extremes;
+    PercentileWindow<STATS_MEDIAN_WINDOW> _window;
+};
+
+// Which statistic the display and text output show in place of the raw value
+enum stats_view_t {
+    STATS_RAW,
+    STATS_FAST,
+    STATS_MID,
+    STATS_SLOW,
+    STATS_MIN,
+    STATS_MAX,
+    STATS_MEDIAN,
+    STATS_P90,
+    STATS_VIEWS
+};
+
+const char *statsViewName(stats_view_t view);
+
+// The viewed statistic, or raw if it is STATS_RAW or there is no summary yet
+uint16_t statsView(const stats_summary_t &summary, stats_view_t view, uint16_t raw);
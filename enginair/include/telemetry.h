@@ -0,0 +1,106 @@
+// enginair telemetry.h
+// Binary telemetry on Serial, as an alternative to the text lines.
+//
+// Frame on the wire: 0x00, COBS(message + CRC-16), 0x00. COBS output has no
+// zero bytes, so a host can always resync at the next delimiter; the leading
+// one keeps a frame intact right after text output. A message is
+//   uint8 version (TELEMETRY_VERSION), uint8 type, body
+// and the CRC-16/CCITT-FALSE (crc16.h) covers version, type and body. All
+// fields are little-endian. Decoder: tools/telemetry.py.
+//
+// Each frame goes out in a single halSerialWrite(), which holds the serial
+// lock throughout (hal.h), so both cores can send without tearing frames or
+// text lines. A sample frame is 28 bytes on the wire against ~110 for the
+// two text lines, so even 10 Hz is a few hundred bytes per second.
+
+#pragma once
+
+#include <stdint.h>
+#include "sample.h"
+
+#define TELEMETRY_VERSION 1
+
+enum telemetry_mode_t {
+    TELEMETRY_TEXT,   // human readable lines (default)
+    TELEMETRY_BINARY, // framed messages; console replies stay text
+};
+
+enum telemetry_type_t {
+    TELEMETRY_SAMPLE = 1,
+    TELEMETRY_ERROR = 2,
+    TELEMETRY_STATS = 3,
+    TELEMETRY_TRACE = 4,
+    TELEMETRY_PM_STATS = 5,
+    TELEMETRY_AQI = 6,
+};
+
+struct __attribute__((packed)) telemetry_sample_t {
+    uint16_t sequence; // per sample frame, to spot drops
+    uint32_t time;     // tick time, micros
+    uint8_t flags;     // SAMPLE_*
+    uint16_t pm1p0, pm2p5, pm4p0, pm10p0; // raw ticks, see sample.h
+    uint16_t co2;
+    uint16_t temp, humi;
+};
+
+struct __attribute__((packed)) telemetry_error_t {
+    uint16_t code; // SENSIRION_ERR_*
+    // followed by the context text, not terminated
+};
+
+struct __attribute__((packed)) telemetry_stats_t {
+    uint32_t time;          // micros
+    uint32_t queueDropped;  // samples core 1 didn't keep up with
+    uint32_t co2Checks;     // see scd40_bus_stats_t
+    uint32_t co2Reads;
+    uint32_t co2Saved;
+    uint32_t co2Misses;
+    uint32_t oledFrames;    // see oled_stats_t
+    uint32_t oledSkipped;
+};
+
+// PM2.5 statistics (stats.h), sent after each sample frame once there are
+// any. Values in PM ticks, like the sample.
+struct __attribute__((packed)) telemetry_pm_stats_t {
+    uint32_t time;   // tick time of the sample they include
+    uint16_t count;  // samples in the median window
+    uint16_t fast, mid, slow; // EWMAs
+    uint16_t min, max;        // over STATS_MINMAX_WINDOW samples
+    uint16_t median, p90;     // over STATS_MEDIAN_WINDOW samples
+};
+
+// Air quality indices (aqi.h), sent after a sample frame whenever they
+// changed, i.e. about once a minute. AQI_INVALID where there is no value.
+struct __attribute__((packed)) telemetry_aqi_t {
+    uint32_t time;       // tick time of the sample they include
+    uint16_t pm2p5Hour, pm2p5Day, pm10Hour, pm10Day; // PM ticks
+    uint16_t pm2p5NowCast, pm10NowCast;
+    uint16_t us;         // US AQI
+    uint8_t usCategory;  // aqi_category_t
+    uint16_t caqiHour, caqiDay;
+};
+
+// One sensor I2C transaction, see trace.h
+struct __attribute__((packed)) telemetry_trace_t {
+    uint16_t sequence; // per trace frame; a gap means the trace is unusable
+    uint32_t time;     // micros
+    uint8_t address;
+    uint8_t op;        // TRACE_WRITE or TRACE_READ
+    uint8_t result;    // write: Wire status; read: bytes returned
+    // followed by the bytes written or returned
+};
+
+#define TELEMETRY_MAX_BODY 48
+
+extern volatile telemetry_mode_t telemetryMode;
+
+inline bool telemetryBinary() {
+    return telemetryMode == TELEMETRY_BINARY;
+}
+
+// Frame and send one message (body up to TELEMETRY_MAX_BODY bytes)
+void telemetrySend(uint8_t type, const void *body, uint8_t length);
+
+// A sample frame, then the PM2.5 statistics and AQI frames if due
+void telemetrySample(const sample_t &sample);
+void telemetryError(const char *context, uint16_t code);
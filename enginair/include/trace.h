@@ -0,0 +1,30 @@
+// enginair trace.h
+// Capture of the raw sensor traffic, for replay on the host. Every Sensirion
+// transaction (command bytes written, bytes read back, Wire status, time) is
+// queued by core 0 and sent by core 1 as a TELEMETRY_TRACE frame.
+//
+// A replayable trace has to start at reset, as the drivers' boot sequence is
+// part of it: build env:rpipico_capture (ENGINAIR_CAPTURE), open the port,
+// and save the output with tools/telemetry.py --trace. Entries are held until
+// the port is open. Replay it with the native build:
+//
+//     program --replay trace.txt
+
+#pragma once
+
+#include <stdint.h>
+
+#define TRACE_WRITE 0
+#define TRACE_READ 1
+#define TRACE_MAX_DATA 27 // SENSIRION_MAX_WORDS * 3
+
+extern volatile bool traceCapture;
+
+// Core 0, after each transaction. No-op unless capturing.
+void traceI2C(uint8_t address, uint8_t op, uint8_t result, const uint8_t *data, uint8_t length);
+
+// Core 1: send whatever has been queued
+void tracePoll();
+
+// Entries lost because core 1 or the port didn't keep up
+uint32_t traceDropped();
@@ -0,0 +1,195 @@
+// enginair native/hal_native.cpp
+// hal.h on the host: virtual clock, stdio serial, RAM-backed flash
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "sim.h"
+
+static uint64_t now = 0;
+static bool eventPending = false;
+static bool inputOpen = false;
+static bool inputEnded = false;
+static uint8_t *capture = nullptr;
+static uint32_t captureSize = 0;
+static uint32_t captured = 0;
+
+static uint8_t flash[HAL_FLASH_SIZE];
+static const char *flashFile = nullptr;
+
+uint64_t simTime() {
+    return now;
+}
+
+void simAdvanceTo(uint64_t t) {
+    if (t > now) {
+        now = t;
+    }
+}
+
+uint32_t halMicros() {
+    return (uint32_t)now;
+}
+
+uint64_t halMicros64() {
+    return now;
+}
+
+// Host nanoseconds stand in for cycles
+uint32_t halCycles() {
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+}
+
+uint32_t halCyclesPerMicro() {
+    return 1000;
+}
+
+// The alarm interrupt. On the device it preempts whatever runs; here code
+// only yields when it sleeps, so a deadline that time jumped past (e.g.
+// during an I2C transfer) fires late but is stamped as on time, the way
+// the interrupt would have stamped it.
+static hal_alarm_fn_t alarmFn = nullptr;
+static uint64_t alarmDue;
+static uint32_t alarmPeriod;
+
+static void alarmFire(uint64_t t) {
+    simAdvanceTo(t);
+    uint32_t due = (uint32_t)alarmDue;
+    alarmDue += alarmPeriod;
+    alarmFn(due, due);
+}
+
+void halAlarmStart(uint32_t first, uint32_t period, hal_alarm_fn_t fn) {
+    alarmFn = fn;
+    alarmPeriod = period;
+    alarmDue = now + (int32_t)(first - (uint32_t)now);
+    while (alarmDue <= now) {
+        alarmDue += period;
+    }
+}
+
+void halAlarmStop() {
+    alarmFn = nullptr;
+}
+
+// An event that is already pending (or an alarm already due) ends the sleep
+// at once, as WFE would; otherwise time jumps ahead to t, or to the alarm
+// if that comes first
+void halSleepUntil(uint32_t t) {
+    if (alarmFn && alarmDue <= now) {
+        alarmFire(alarmDue);
+        return;
+    }
+    if (eventPending) {
+        eventPending = false;
+        return;
+    }
+    int32_t wait = (int32_t)(t - (uint32_t)now);
+    if (alarmFn && wait > 0 && alarmDue <= now + wait) {
+        alarmFire(alarmDue);
+        return;
+    }
+    if (wait > 0) {
+        now += wait;
+    }
+}
+
+void halWaitEvent() {
+    eventPending = false;
+}
+
+void halSignalEvent() {
+    eventPending = true;
+}
+
+void halSerialBegin() {
+}
+
+void halSerialWrite(const void *data, size_t length) {
+    if (!capture) {
+        fwrite(data, 1, length, stdout);
+        return;
+    }
+    size_t room = captureSize - captured;
+    length = length < room ? length : room;
+    memcpy(capture + captured, data, length);
+    captured += length;
+}
+
+void halSerialPrintln(const char *text) {
+    halSerialWrite(text, strlen(text));
+    halSerialWrite("\r\n", 2);
+}
+
+int halSerialRead() {
+    if (!inputOpen || inputEnded) {
+        return -1;
+    }
+    int c = getchar();
+    if (c == EOF) {
+        inputEnded = true;
+        return -1;
+    }
+    return c;
+}
+
+bool halSerialConnected() {
+    return true;
+}
+
+void simOpenInput() {
+    fflush(stdout);
+    inputOpen = true;
+}
+
+bool simInputEnded() {
+    return inputEnded;
+}
+
+void simSerialCapture(uint8_t *buffer, uint32_t size) {
+    capture = buffer;
+    captureSize = size;
+    captured = 0;
+}
+
+uint32_t simSerialCaptured() {
+    return captured;
+}
+
+const uint8_t *halFlashData() {
+    return flash;
+}
+
+void halFlashWriteSector(uint32_t offset, const uint8_t *data) {
+    if (offset + HAL_FLASH_SECTOR_SIZE <= HAL_FLASH_SIZE) {
+        memcpy(flash + offset, data, HAL_FLASH_SECTOR_SIZE);
+    }
+}
+
+void simBegin(const char *flashPath) {
+    memset(flash, 0xFF, sizeof(flash));
+    flashFile = flashPath;
+    if (!flashFile) {
+        return;
+    }
+    FILE *f = fopen(flashFile, "rb");
+    if (f) {
+        size_t n = fread(flash, 1, sizeof(flash), f);
+        (void)n; // a short image leaves the rest erased
+        fclose(f);
+    }
+}
+
+void simEnd() {
+    fflush(stdout);
+    if (!flashFile) {
+        return;
+    }
+    FILE *f = fopen(flashFile, "wb");
+    if (f) {
+        fwrite(flash, 1, sizeof(flash), f);
+        fclose(f);
+    }
+}
@@ -0,0 +1,38 @@
+// enginair native/i2c_native.cpp
+// i2c_bus.h on the host: transactions go straight to the device models.
+// Everything runs on one thread, so the bus lock has nothing to do.
+
+#include "i2c_bus.h"
+#include "hal.h"
+#include "sim.h"
+
+static SimDevice *devices[128];
+
+void simAttach(uint8_t address, SimDevice *device) {
+    devices[address & 0x7F] = device;
+}
+
+void i2cBusInit() {
+}
+
+void i2cBusLock() {
+}
+
+void i2cBusUnlock() {
+}
+
+uint8_t i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+    SimDevice *device = devices[address & 0x7F];
+    if (!device) {
+        return 2; // address NACK, as Wire reports it
+    }
+    return device->write(data, length, halMicros()) ? 0 : device->nackStatus();
+}
+
+uint8_t i2cRead(uint8_t address, uint8_t *data, uint8_t length) {
+    SimDevice *device = devices[address & 0x7F];
+    if (!device) {
+        return 0;
+    }
+    return device->read(data, length, halMicros());
+}
@@ -0,0 +1,136 @@
+// enginair native/main_native.cpp
+// Entry point of the native build: runs the firmware's setup()/loop() for
+// core 0 and setup1()/loop1() for core 1 on one thread, interleaved, against
+// the simulated board (sim.h).
+//
+//   program [seconds] [--show] [--flash image.bin] [--replay trace.txt]
+//
+// Runs for `seconds` of virtual time (default 3600), then feeds stdin to the
+// serial console, e.g.  echo "history 1" | program 7200
+//
+// With --replay, the sensors are played back from a captured trace (see
+// trace.h) instead of simulated, for as long as the trace lasts, and a
+// per-stage cost report goes to stderr at the end.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "sim_sensirion.h"
+#include "sim_ssd1306.h"
+#include "sim_replay.h"
+#include "oled.h"
+#include "scd40.h"
+#include "sen50.h"
+#include "profile.h"
+
+void setup();
+void loop();
+void setup1();
+void loop1();
+
+static SimScd40 scd40;
+static SimSen50 sen50;
+static SimSsd1306 panel;
+static SimReplay scd40Replay;
+static SimReplay sen50Replay;
+
+#define REPLAY_TAIL_US 2000000 // keep running after the last entry, for the output it triggers
+
+void simDisplayDump() {
+    panel.dump();
+}
+
+// The unit tests (test/) bring their own main() and drive the modules directly
+#ifndef PIO_UNIT_TESTING
+
+// Host time spent per stage (profile.h; on the host, "cycles" are ns)
+static void replayReport(double wallSeconds) {
+    double simSeconds = simTime() / 1e6;
+    fprintf(stderr, "replay: %u transactions, %.1f s in %.3f s (%.0fx real time), %u divergences\n",
+            scd40Replay.replayed + sen50Replay.replayed, simSeconds, wallSeconds,
+            wallSeconds > 0 ? simSeconds / wallSeconds : 0.0,
+            scd40Replay.divergences + sen50Replay.divergences);
+    fprintf(stderr, "%-8s %8s %10s %10s %10s %10s %12s\n", "stage", "count", "mean us", "p50 us",
+            "p99 us", "max us", "total ms");
+    for (uint8_t s = 0; s < PROFILE_STAGES; s++) {
+        profile_summary_t summary;
+        if (!profileSummary((profile_stage_t)s, summary)) {
+            continue;
+        }
+        fprintf(stderr, "%-8s %8u %10.2f %10.2f %10.2f %10.2f %12.2f\n",
+                profileStageName((profile_stage_t)s), summary.count,
+                summary.total / 1e3 / summary.count, summary.p50 / 1e3, summary.p99 / 1e3,
+                summary.max / 1e3, summary.total / 1e6);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t seconds = 3600;
+    bool show = false;
+    const char *flashPath = nullptr;
+    const char *replayPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--show") == 0) {
+            show = true;
+        } else if (strcmp(argv[i], "--flash") == 0 && i + 1 < argc) {
+            flashPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else {
+            seconds = strtoull(argv[i], nullptr, 10);
+        }
+    }
+
+    simBegin(flashPath);
+    if (replayPath) {
+        if (!scd40Replay.load(replayPath, SCD40_ADDRESS) || !sen50Replay.load(replayPath, SEN50_ADDRESS)) {
+            fprintf(stderr, "can't load trace %s\n", replayPath);
+            return 1;
+        }
+        simAttach(SCD40_ADDRESS, &scd40Replay);
+        simAttach(SEN50_ADDRESS, &sen50Replay);
+    } else {
+        simAttach(SCD40_ADDRESS, &scd40);
+        simAttach(SEN50_ADDRESS, &sen50);
+    }
+    simAttach(OLED_ADDRESS, &panel);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    setup();
+    setup1();
+    uint64_t end = seconds * 1000000;
+    if (replayPath) {
+        uint64_t last = scd40Replay.lastTime();
+        if (sen50Replay.lastTime() > last) {
+            last = sen50Replay.lastTime();
+        }
+        end = last + REPLAY_TAIL_US;
+    }
+    while (simTime() < end && !scd40Replay.ended() && !sen50Replay.ended()) {
+        loop();
+        loop1();
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    if (replayPath) {
+        replayReport(wall.count());
+    }
+
+    simOpenInput();
+    while (!simInputEnded()) {
+        loop1();
+    }
+
+    if (show) {
+        simDisplayDump();
+    }
+    if (!replayPath) {
+        fprintf(stderr, "simulated %llu s: SCD40 %u commands, SEN50 %u commands, SSD1306 %u bytes\n",
+                (unsigned long long)seconds, scd40.commands, sen50.commands, panel.bytes);
+    }
+    simEnd();
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,108 @@
+// enginair native/oled_native.cpp
+// oled.h on the host: frames go to the SSD1306 model synchronously. Like
+// the DMA version, only the changed columns of each page are sent, in runs
+// split where they are further apart than OLED_RANGE_GAP, so the byte
+// counts stay comparable.
+
+#include <string.h>
+#include "oled.h"
+#include "i2c_bus.h"
+#include "profile.h"
+
+#define SSD1306_CTRL_CMD 0x00
+#define SSD1306_CTRL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_CHARGEPUMP 0x8D
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define OLED_CHUNK 128 // data bytes per I2C transaction
+#define OLED_RANGE_GAP 8 // as oled.cpp: closer runs are cheaper merged
+
+static uint8_t shown[OLED_BUFFER_SIZE];
+static bool fullRefresh = true;
+static oled_done_fn_t doneFn = nullptr;
+static oled_stats_t stats = {};
+
+void oledBegin() {
+    fullRefresh = true;
+}
+
+static void sendPage(uint8_t page, uint8_t first, uint8_t last, const uint8_t *row) {
+    uint8_t cmds[] = {SSD1306_CTRL_CMD, SSD1306_COLUMNADDR, first, last, SSD1306_PAGEADDR, page, page};
+    I2CBusGuard bus;
+    i2cWrite(OLED_ADDRESS, cmds, sizeof(cmds));
+    for (uint16_t c = first; c <= last; c += OLED_CHUNK) {
+        uint8_t data[1 + OLED_CHUNK];
+        uint8_t n = last - c + 1 < OLED_CHUNK ? last - c + 1 : OLED_CHUNK;
+        data[0] = SSD1306_CTRL_DATA;
+        memcpy(data + 1, row + c, n);
+        i2cWrite(OLED_ADDRESS, data, n + 1);
+        stats.bytes += n;
+    }
+}
+
+void oledFlushAsync(const uint8_t *buffer) {
+    uint32_t start = profileStart();
+    bool changed = false;
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        const uint8_t *row = buffer + page * OLED_WIDTH;
+        const uint8_t *old = shown + page * OLED_WIDTH;
+        int16_t first = -1, last = -1;
+        for (uint8_t x = 0; x < OLED_WIDTH; x++) {
+            if (!fullRefresh && row[x] == old[x]) {
+                continue;
+            }
+            if (first >= 0 && x - last > OLED_RANGE_GAP) {
+                sendPage(page, first, last, row);
+                first = -1;
+            }
+            if (first < 0) {
+                first = x;
+            }
+            last = x;
+        }
+        if (first >= 0) {
+            sendPage(page, first, last, row);
+            changed = true;
+        }
+    }
+    memcpy(shown, buffer, OLED_BUFFER_SIZE);
+    fullRefresh = false;
+
+    if (!changed) {
+        stats.skipped++;
+        return;
+    }
+    stats.frames++;
+    profileEnd(PROFILE_FLUSH, start);
+    if (doneFn) {
+        doneFn();
+    }
+}
+
+void oledFlush(const uint8_t *buffer) {
+    oledFlushAsync(buffer);
+}
+
+void oledPoll() {
+}
+
+void oledSetPower(bool on) {
+    const uint8_t off[] = {SSD1306_CTRL_CMD, SSD1306_DISPLAYOFF, SSD1306_CHARGEPUMP, 0x10};
+    const uint8_t wake[] = {SSD1306_CTRL_CMD, SSD1306_CHARGEPUMP, 0x14, SSD1306_DISPLAYON};
+    I2CBusGuard bus;
+    i2cWrite(OLED_ADDRESS, on ? wake : off, sizeof(off));
+}
+
+bool oledBusy() {
+    return false;
+}
+
+void oledOnFlushDone(oled_done_fn_t fn) {
+    doneFn = fn;
+}
+
+oled_stats_t oledStats() {
+    return stats;
+}
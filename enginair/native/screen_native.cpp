@@ -0,0 +1,116 @@
+// enginair native/screen_native.cpp
+// screen.h on the host. The page-drawn screens are the device's
+// (screen_page.h, ArialMT fonts), pixel for pixel; the GFX boot messages
+// are reduced to serial output.
+
+#include <string.h>
+#include "screen.h"
+#include "screen_page.h"
+#include "page_fonts.h"
+#include "hal.h"
+#include "i2c_bus.h"
+#include "oled.h"
+#include "fmt.h"
+#include "bench.h"
+#include "sample.h"
+
+static uint8_t frame[OLED_BUFFER_SIZE];
+
+// Whether the frame still holds the trend screen as showTrend() left it
+static bool trendShown = false;
+
+bool initDisplay() {
+    // What Adafruit_SSD1306::begin() leaves set up: horizontal addressing,
+    // charge pump on, panel on
+    static const uint8_t init[] = {0x00, 0xAE, 0x20, 0x00, 0x8D, 0x14, 0xAF};
+    uint8_t status;
+    {
+        I2CBusGuard bus;
+        status = i2cWrite(OLED_ADDRESS, init, sizeof(init));
+    }
+    if (status) {
+        halSerialPrintln("Couldn't initialise SSD1306");
+        return false;
+    }
+    oledBegin();
+
+    screenPageBegin();
+
+    memset(frame, 0, sizeof(frame));
+    oledFlush(frame);
+    return true;
+}
+
+void showMessage(const char *message, message_t level) {
+    trendShown = false;
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = line;
+    *p = '\0';
+    switch (level) {
+        case DEBUG: p = fmtStr(p, end, "DEBUG: "); break;
+        case INFO: p = fmtStr(p, end, "INFO: "); break;
+        case WARN: p = fmtStr(p, end, "WARN: "); break;
+        case ERR: p = fmtStr(p, end, "ERROR: "); break;
+        case NAME: p = fmtStr(p, end, PROJECT_NAME ": "); break;
+    }
+    memset(frame, 0, sizeof(frame));
+    oledFlush(frame);
+    fmtStr(p, end, message);
+    halSerialPrintln(line);
+}
+
+void showValues_LargeText(uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    trendShown = false;
+    screenDrawValues(frame, pm2p5, co2, temp, humi, flags);
+    oledFlushAsync(frame);
+}
+
+void showTrend(trend_mode_t mode) {
+    screenDrawTrend(frame, mode, trendShown);
+    trendShown = true;
+    oledFlushAsync(frame);
+}
+
+void showPMValues(uint16_t pm1p0, uint16_t pm2p5, uint16_t pm4p0, uint16_t pm10p0, uint8_t flags) {
+    (void)pm1p0;
+    (void)pm4p0;
+    trendShown = false;
+    screenDrawPM(frame, pm2p5, pm10p0, flags);
+    oledFlushAsync(frame);
+}
+
+void showCO2Values(uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    trendShown = false;
+    screenDrawClimate(frame, co2, temp, humi, flags);
+    oledFlushAsync(frame);
+}
+
+void showStats(const screen_stats_t &stats) {
+    trendShown = false;
+    screenDrawStats(frame, stats);
+    oledFlushAsync(frame);
+}
+
+void showAQIValues(const aqi_t &aqi) {
+    trendShown = false;
+    screenDrawAQI(frame, aqi);
+    oledFlushAsync(frame);
+}
+
+// Only the page renderer exists here
+static void framePage(uint32_t i) {
+    screenDrawValues(frame, (i * 377) % 10000, 400 + (i * 1543) % 40000, (int16_t)((i * 37) % 700) - 100,
+                     (i * 113) % 1001, SAMPLE_PM_VALID | SAMPLE_CO2_VALID);
+}
+
+static void frameClimate(uint32_t i) {
+    screenDrawClimate(frame, 400 + (i * 1543) % 40000, (int16_t)((i * 37) % 700) - 100, (i * 113) % 1001,
+                      SAMPLE_CO2_VALID);
+}
+
+void screenBench() {
+    trendShown = false; // the bench draws into the frame
+    benchReport("frame page", benchCycles(framePage, 64));
+    benchReport("frame climate", benchCycles(frameClimate, 64));
+}
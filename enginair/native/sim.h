@@ -0,0 +1,56 @@
+// enginair native/sim.h
+// Simulated board for the native build (env:native): a virtual clock, an
+// I2C bus with models of the SCD40, SEN50 and SSD1306 on it, RAM-backed
+// flash and stdio for the serial port. The application code in src/ runs
+// unchanged on top of it through hal.h, i2c_bus.h and oled.h.
+//
+// Time is virtual: it only moves when the firmware sleeps, and then jumps
+// straight to the wake-up time, so hours of operation run in seconds and
+// profilers only see the firmware's own work.
+
+#pragma once
+
+#include <stdint.h>
+
+// A device on the simulated I2C bus
+class SimDevice {
+public:
+    virtual ~SimDevice() {}
+
+    // One write transaction. Return false to NACK it.
+    virtual bool write(const uint8_t *data, uint8_t length, uint32_t now) = 0;
+
+    // Wire status to report for the last NACKed write (3: data NACK)
+    virtual uint8_t nackStatus() const { return 3; }
+
+    // One read transaction. Returns the number of bytes supplied (0: NACK).
+    virtual uint8_t read(uint8_t *data, uint8_t length, uint32_t now) = 0;
+};
+
+void simAttach(uint8_t address, SimDevice *device);
+
+// Virtual time since start, in microseconds
+uint64_t simTime();
+
+// Move virtual time forward to t (no-op if already past it)
+void simAdvanceTo(uint64_t t);
+
+// Load the flash image from path if it exists (else start erased), and
+// write it back there in simEnd(). nullptr: RAM only.
+void simBegin(const char *flashPath);
+void simEnd();
+
+// Serial input is held back until the timed run is over, then read from
+// stdin; true once stdin is exhausted.
+void simOpenInput();
+bool simInputEnded();
+
+// Collect serial output in buffer (up to size bytes, the rest is dropped)
+// instead of writing it to stdout, for tests. nullptr: stdout again.
+void simSerialCapture(uint8_t *buffer, uint32_t size);
+
+// Bytes collected since simSerialCapture()
+uint32_t simSerialCaptured();
+
+// Print the simulated panel contents as text
+void simDisplayDump();
@@ -0,0 +1,121 @@
+// enginair native/sim_replay.cpp
+// Trace playback device, see sim_replay.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_replay.h"
+
+#define REPLAY_MAX_REPORTED 10 // divergences printed, the rest are counted
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool SimReplay::load(const char *path, uint8_t address) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    _address = address;
+    char line[256];
+    uint32_t lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        unsigned long long time;
+        unsigned addr, result;
+        char op;
+        char hex[128];
+        if (sscanf(line, "%llu %x %c %u %127s", &time, &addr, &op, &result, hex) != 5
+            || (op != 'W' && op != 'R')) {
+            fprintf(stderr, "%s:%u: malformed trace line\n", path, lineNumber);
+            ok = false;
+            break;
+        }
+        if (addr != address) {
+            continue;
+        }
+        replay_entry_t entry = {};
+        entry.time = time;
+        entry.op = op == 'W' ? TRACE_WRITE : TRACE_READ;
+        entry.result = result;
+        if (strcmp(hex, "-") != 0) {
+            for (size_t i = 0; hex[i] && hex[i + 1] && entry.length < TRACE_MAX_DATA; i += 2) {
+                int hi = hexNibble(hex[i]);
+                int lo = hexNibble(hex[i + 1]);
+                if (hi < 0 || lo < 0) {
+                    fprintf(stderr, "%s:%u: bad hex data\n", path, lineNumber);
+                    ok = false;
+                    break;
+                }
+                entry.data[entry.length++] = (hi << 4) | lo;
+            }
+        }
+        _entries.push_back(entry);
+    }
+    fclose(f);
+    return ok;
+}
+
+// Next recorded transaction, which should be of kind op. A mismatch is
+// counted but still consumed, so one stray command doesn't derail the rest.
+const replay_entry_t *SimReplay::next(uint8_t op) {
+    if (_next >= _entries.size()) {
+        _ended = true;
+        return nullptr;
+    }
+    const replay_entry_t *entry = &_entries[_next++];
+    simAdvanceTo(entry->time);
+    replayed++;
+    if (entry->op != op) {
+        if (divergences++ < REPLAY_MAX_REPORTED) {
+            fprintf(stderr, "replay 0x%02x at %llu us: firmware %s, trace has a %s\n", _address,
+                    (unsigned long long)entry->time, op == TRACE_WRITE ? "wrote" : "read",
+                    entry->op == TRACE_WRITE ? "write" : "read");
+        }
+        return nullptr;
+    }
+    return entry;
+}
+
+bool SimReplay::write(const uint8_t *data, uint8_t length, uint32_t now) {
+    (void)now;
+    const replay_entry_t *entry = next(TRACE_WRITE);
+    if (!entry) {
+        // Past the end, a write is ACKed so the run stops without a made-up
+        // error; a mismatch NACKs it
+        _status = 3;
+        return _ended;
+    }
+    if ((entry->length != length || memcmp(entry->data, data, length) != 0)
+        && divergences++ < REPLAY_MAX_REPORTED) {
+        fprintf(stderr, "replay 0x%02x at %llu us: firmware wrote a different command\n", _address,
+                (unsigned long long)entry->time);
+    }
+    _status = entry->result;
+    return entry->result == 0;
+}
+
+uint8_t SimReplay::read(uint8_t *data, uint8_t length, uint32_t now) {
+    (void)now;
+    const replay_entry_t *entry = next(TRACE_READ);
+    if (!entry) {
+        return 0;
+    }
+    uint8_t n = entry->length < length ? entry->length : length;
+    memcpy(data, entry->data, n);
+    return n;
+}
@@ -0,0 +1,53 @@
+// enginair native/sim_replay.h
+// Plays a captured sensor trace (see trace.h) back in place of the sensor
+// models. Each address answers from its own recorded transactions, in
+// order: writes are acknowledged (or NACKed) as they were, reads return
+// the recorded bytes, including short reads and bad CRCs. Virtual time is
+// pulled forward to each transaction's recorded time, so the firmware sees
+// the timing the device saw.
+//
+// Trace file, one transaction per line (tools/telemetry.py --trace):
+//   <micros since reset> <address, hex> W|R <result> <data, hex or ->
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "sim.h"
+#include "trace.h"
+
+struct replay_entry_t {
+    uint64_t time;
+    uint8_t op;     // TRACE_WRITE or TRACE_READ
+    uint8_t result; // write: Wire status; read: bytes returned
+    uint8_t length;
+    uint8_t data[TRACE_MAX_DATA];
+};
+
+class SimReplay : public SimDevice {
+public:
+    // Read the entries for this device's address from path. False if the
+    // file can't be read or is malformed.
+    bool load(const char *path, uint8_t address);
+
+    bool write(const uint8_t *data, uint8_t length, uint32_t now) override;
+    uint8_t read(uint8_t *data, uint8_t length, uint32_t now) override;
+    uint8_t nackStatus() const override { return _status; }
+
+    // The firmware asked for more than was recorded. The run should stop
+    // after this loop pass.
+    bool ended() const { return _ended; }
+    uint64_t lastTime() const { return _entries.empty() ? 0 : _entries.back().time; }
+
+    uint32_t replayed = 0;
+    uint32_t divergences = 0; // firmware did something other than the recording
+
+private:
+    const replay_entry_t *next(uint8_t op);
+
+    std::vector<replay_entry_t> _entries;
+    size_t _next = 0;
+    uint8_t _address = 0;
+    uint8_t _status = 3; // recorded result of the last write
+    bool _ended = false;
+};
@@ -0,0 +1,141 @@
+// enginair native/sim_sensirion.cpp
+// SCD40 and SEN50 models, see sim_sensirion.h
+
+#include <math.h>
+#include "sim_sensirion.h"
+
+#define SCD4X_PERIOD_US 5000000
+#define SCD4X_LOW_POWER_PERIOD_US 30000000
+#define SEN5X_PERIOD_US 1000000
+#define SEN5X_NO_VALUE 0xFFFF  // PM before the first measurement
+#define SEN50_NO_SENSOR 0x7FFF // RH, T, VOC, NOx: not fitted on the SEN50
+
+bool SimSensirion::write(const uint8_t *data, uint8_t length, uint32_t now) {
+    if ((int32_t)(now - _busyUntil) < 0 || length < 2) {
+        return false;
+    }
+    _words = 0;
+    int32_t exec = command((data[0] << 8) | data[1], now);
+    if (exec < 0) {
+        return false;
+    }
+    commands++;
+    _busyUntil = now + exec;
+    return true;
+}
+
+uint8_t SimSensirion::read(uint8_t *data, uint8_t length, uint32_t now) {
+    if ((int32_t)(now - _busyUntil) < 0 || _words == 0) {
+        return 0;
+    }
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _words && n + 3 <= length; i++) {
+        data[n] = _response[i] >> 8;
+        data[n + 1] = _response[i] & 0xFF;
+        data[n + 2] = sensirionCrc(data + n, 2);
+        n += 3;
+    }
+    _words = 0;
+    return n;
+}
+
+// --- SCD40 ---
+
+uint32_t SimScd40::samplesSince(uint64_t time) {
+    uint64_t period = (uint64_t)_period * 1000000 / (1000000 + clockErrorPpm);
+    return (uint32_t)((time - _start) / period);
+}
+
+int32_t SimScd40::command(uint16_t cmd, uint32_t now) {
+    (void)now;
+    switch (cmd) {
+        case 0x21B1: // start_periodic_measurement
+        case 0x21AC: // start_low_power_periodic_measurement
+            if (_measuring) {
+                return -1; // only accepted while idle
+            }
+            _measuring = true;
+            _period = cmd == 0x21AC ? SCD4X_LOW_POWER_PERIOD_US : SCD4X_PERIOD_US;
+            _start = simTime();
+            _read = 0;
+            return 0;
+        case 0x3F86: // stop_periodic_measurement
+            _measuring = false;
+            return 500000;
+        case 0xE4B8: // get_data_ready_status
+            if (!_measuring) {
+                return -1;
+            }
+            _response[0] = samplesSince(simTime()) > _read ? 0x8006 : 0x8000;
+            _words = 1;
+            return 1000;
+        case 0xEC05: { // read_measurement: NACKs the read if nothing new
+            if (!_measuring) {
+                return -1;
+            }
+            uint32_t available = samplesSince(simTime());
+            if (available > _read) {
+                _read = available;
+                double t = simTime() / 1e6;
+                double co2 = 650 + 250 * sin(t / 1800) + 15 * sin(t / 37);
+                double temp = 22.5 + 1.5 * sin(t / 5400);
+                double humi = 45 + 5 * sin(t / 7200);
+                _response[0] = (uint16_t)co2;
+                _response[1] = (uint16_t)((temp + 45) * 65536 / 175);
+                _response[2] = (uint16_t)(humi * 65536 / 100);
+                _words = 3;
+            }
+            return 1000;
+        }
+        default:
+            return -1;
+    }
+}
+
+// --- SEN50 ---
+
+int32_t SimSen50::command(uint16_t cmd, uint32_t now) {
+    (void)now;
+    switch (cmd) {
+        case 0xD304: // device_reset
+            _measuring = false;
+            return 100000;
+        case 0x0021: // start_measurement
+            _measuring = true;
+            _start = simTime();
+            _read = 0;
+            return 50000;
+        case 0x0104: // stop_measurement (to idle mode)
+            _measuring = false;
+            return 200000;
+        case 0x0202: // read_data_ready
+            _response[0] = _measuring && (simTime() - _start) / SEN5X_PERIOD_US > _read ? 0x0001 : 0x0000;
+            _words = 1;
+            return 20000;
+        case 0x03C4: { // read_measured_values
+            uint32_t available = _measuring ? (simTime() - _start) / SEN5X_PERIOD_US : 0;
+            uint16_t pm2p5 = SEN5X_NO_VALUE;
+            if (available > 0) {
+                while (_read < available) { // one random walk step per sample
+                    _seed = _seed * 1103515245 + 12345;
+                    _pm += (int)((_seed >> 16) % 9) - 4;
+                    _pm = _pm < 10 ? 10 : _pm;
+                    _read++;
+                }
+                pm2p5 = (uint16_t)_pm;
+            }
+            bool valid = pm2p5 != SEN5X_NO_VALUE;
+            _response[0] = valid ? (uint16_t)(pm2p5 * 0.8) : SEN5X_NO_VALUE;
+            _response[1] = pm2p5;
+            _response[2] = valid ? (uint16_t)(pm2p5 * 1.05) : SEN5X_NO_VALUE;
+            _response[3] = valid ? (uint16_t)(pm2p5 * 1.1) : SEN5X_NO_VALUE;
+            for (uint8_t i = 4; i < 8; i++) {
+                _response[i] = SEN50_NO_SENSOR;
+            }
+            _words = 8;
+            return 20000;
+        }
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,62 @@
+// enginair native/sim_sensirion.h
+// Models of the Sensirion sensors: command decoding, execution times (the
+// sensor NACKs while busy), CRC'd responses and plausible slowly varying
+// readings.
+
+#pragma once
+
+#include <stdint.h>
+#include "sim.h"
+#include "sensirion.h"
+
+// What every Sensirion device shares: a command with an execution time and
+// an optional response to read once it has finished
+class SimSensirion : public SimDevice {
+public:
+    bool write(const uint8_t *data, uint8_t length, uint32_t now) override;
+    uint8_t read(uint8_t *data, uint8_t length, uint32_t now) override;
+
+    uint32_t commands = 0; // accepted, for the bus statistics
+
+protected:
+    // Handle cmd; fill _response/_words if it returns data. Returns the
+    // execution time in us, or -1 to NACK the command.
+    virtual int32_t command(uint16_t cmd, uint32_t now) = 0;
+
+    uint16_t _response[SENSIRION_MAX_WORDS];
+    uint8_t _words = 0;
+
+private:
+    uint32_t _busyUntil = 0;
+};
+
+class SimScd40 : public SimSensirion {
+public:
+    // The sensor's own clock runs this much fast (+) or slow (-), in ppm, so
+    // the read phase tracking has something to track
+    int32_t clockErrorPpm = 8000;
+
+protected:
+    int32_t command(uint16_t cmd, uint32_t now) override;
+
+private:
+    uint32_t samplesSince(uint64_t time);
+
+    // Measurement timing runs on simTime(), which doesn't wrap like now does
+    bool _measuring = false;
+    uint32_t _period = 0; // of the mode it was started in
+    uint64_t _start = 0;
+    uint32_t _read = 0; // samples read out since start
+};
+
+class SimSen50 : public SimSensirion {
+protected:
+    int32_t command(uint16_t cmd, uint32_t now) override;
+
+private:
+    bool _measuring = false;
+    uint64_t _start = 0;
+    uint32_t _read = 0;
+    double _pm = 85.0; // PM2.5 ticks (0.1 ug/m3), random walk
+    uint32_t _seed = 12345;
+};
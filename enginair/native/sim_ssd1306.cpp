@@ -0,0 +1,110 @@
+// enginair native/sim_ssd1306.cpp
+// SSD1306 model, see sim_ssd1306.h
+
+#include <stdio.h>
+#include "sim_ssd1306.h"
+
+#define SSD1306_CTRL_CMD 0x00
+#define SSD1306_CTRL_DATA 0x40
+
+// Parameter bytes that follow each multi-byte command
+static uint8_t commandParams(uint8_t cmd) {
+    switch (cmd) {
+        case 0x21: // column address
+        case 0x22: // page address
+            return 2;
+        case 0x20: // memory addressing mode
+        case 0x81: // contrast
+        case 0x8D: // charge pump
+        case 0xA8: // multiplex ratio
+        case 0xD3: // display offset
+        case 0xD5: // clock divide
+        case 0xD9: // pre-charge
+        case 0xDA: // COM pins
+        case 0xDB: // VCOMH deselect
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void SimSsd1306::command(uint8_t byte) {
+    _cmd[_cmdLength++] = byte;
+    if (_cmdLength <= commandParams(_cmd[0])) {
+        return; // wait for the parameters
+    }
+    _cmdLength = 0;
+
+    switch (_cmd[0]) {
+        case 0x21:
+            _colStart = _col = _cmd[1] % OLED_WIDTH;
+            _colEnd = _cmd[2] % OLED_WIDTH;
+            break;
+        case 0x22:
+            _pageStart = _page = _cmd[1] % OLED_PAGES;
+            _pageEnd = _cmd[2] % OLED_PAGES;
+            break;
+        case 0xAE:
+            on = false;
+            break;
+        case 0xAF:
+            on = true;
+            break;
+        default:
+            break; // accepted, nothing to model
+    }
+}
+
+bool SimSsd1306::write(const uint8_t *data, uint8_t length, uint32_t now) {
+    (void)now;
+    if (length == 0) {
+        return true;
+    }
+    bytes += length;
+    bool isData = data[0] == SSD1306_CTRL_DATA;
+    if (!isData && data[0] != SSD1306_CTRL_CMD) {
+        return false; // Co bit / other control bytes aren't used by oled.cpp
+    }
+    for (uint8_t i = 1; i < length; i++) {
+        if (!isData) {
+            command(data[i]);
+            continue;
+        }
+        ram[_page * OLED_WIDTH + _col] = data[i];
+        if (_col == _colEnd) {
+            _col = _colStart;
+            _page = _page == _pageEnd ? _pageStart : _page + 1;
+        } else {
+            _col++;
+        }
+    }
+    return true;
+}
+
+uint8_t SimSsd1306::read(uint8_t *data, uint8_t length, uint32_t now) {
+    (void)data;
+    (void)length;
+    (void)now;
+    return 0; // write-only over I2C
+}
+
+void SimSsd1306::dump() const {
+    printf("+");
+    for (uint8_t x = 0; x < OLED_WIDTH; x++) {
+        putchar('-');
+    }
+    printf("+\n");
+    for (uint8_t y = 0; y < OLED_HEIGHT; y++) {
+        putchar('|');
+        for (uint8_t x = 0; x < OLED_WIDTH; x++) {
+            bool lit = on && (ram[(y / 8) * OLED_WIDTH + x] >> (y & 7)) & 1;
+            putchar(lit ? '#' : ' ');
+        }
+        printf("|\n");
+    }
+    printf("+");
+    for (uint8_t x = 0; x < OLED_WIDTH; x++) {
+        putchar('-');
+    }
+    printf("+\n");
+}
@@ -0,0 +1,31 @@
+// enginair native/sim_ssd1306.h
+// SSD1306 model: decodes the command/data stream from the I2C bus into its
+// display RAM (page addressing, horizontal auto-increment) and counts what
+// crossed the bus.
+
+#pragma once
+
+#include <stdint.h>
+#include "sim.h"
+#include "oled.h"
+
+class SimSsd1306 : public SimDevice {
+public:
+    bool write(const uint8_t *data, uint8_t length, uint32_t now) override;
+    uint8_t read(uint8_t *data, uint8_t length, uint32_t now) override;
+
+    void dump() const;
+
+    uint8_t ram[OLED_BUFFER_SIZE] = {};
+    bool on = false;
+    uint32_t bytes = 0; // including control bytes
+
+private:
+    void command(uint8_t byte);
+
+    uint8_t _cmd[3];
+    uint8_t _cmdLength = 0;
+    uint8_t _colStart = 0, _colEnd = OLED_WIDTH - 1;
+    uint8_t _pageStart = 0, _pageEnd = OLED_PAGES - 1;
+    uint8_t _col = 0, _page = 0;
+};
@@ -0,0 +1,330 @@
+// enginair aqi.cpp
+// Air quality indices, see aqi.h
+
+#include <string.h>
+#include "aqi.h"
+
+// --- Breakpoint tables, concentrations in PM ticks ---
+
+// US EPA, PM2.5 24 h (2024 revision), truncated to 0.1 ug/m3
+static constexpr aqi_breakpoint_t usPm2p5[] = {
+    {0, 90, 0, 50},
+    {91, 354, 51, 100},
+    {355, 554, 101, 150},
+    {555, 1254, 151, 200},
+    {1255, 2254, 201, 300},
+    {2255, 3254, 301, 500},
+};
+
+// US EPA, PM10 24 h, truncated to 1 ug/m3
+static constexpr aqi_breakpoint_t usPm10[] = {
+    {0, 540, 0, 50},
+    {550, 1540, 51, 100},
+    {1550, 2540, 101, 150},
+    {2550, 3540, 151, 200},
+    {3550, 4240, 201, 300},
+    {4250, 6040, 301, 500},
+};
+
+// CITEAIR II CAQI, background, hourly and daily grids
+static constexpr aqi_breakpoint_t caqiPm2p5Hour[] = {
+    {0, 150, 0, 25},
+    {150, 300, 25, 50},
+    {300, 550, 50, 75},
+    {550, 1100, 75, 100},
+};
+
+static constexpr aqi_breakpoint_t caqiPm10Hour[] = {
+    {0, 250, 0, 25},
+    {250, 500, 25, 50},
+    {500, 900, 50, 75},
+    {900, 1800, 75, 100},
+};
+
+static constexpr aqi_breakpoint_t caqiPm2p5Day[] = {
+    {0, 100, 0, 25},
+    {100, 200, 25, 50},
+    {200, 300, 50, 75},
+    {300, 600, 75, 100},
+};
+
+static constexpr aqi_breakpoint_t caqiPm10Day[] = {
+    {0, 150, 0, 25},
+    {150, 300, 25, 50},
+    {300, 500, 50, 75},
+    {500, 1000, 75, 100},
+};
+
+// Bands must start at zero, ascend and join up (step: the gap in ticks
+// between one band's concHi and the next concLo)
+template <uint8_t N>
+constexpr bool contiguous(const aqi_breakpoint_t (&table)[N], uint16_t concStep, uint16_t indexStep) {
+    if (table[0].concLo != 0 || table[0].indexLo != 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < N; i++) {
+        if (table[i].concHi <= table[i].concLo || table[i].indexHi <= table[i].indexLo) {
+            return false;
+        }
+        if (i > 0 && (table[i].concLo != table[i - 1].concHi + concStep
+                      || table[i].indexLo != table[i - 1].indexHi + indexStep)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(contiguous(usPm2p5, 1, 1), "US PM2.5 breakpoints");
+static_assert(contiguous(usPm10, 10, 1), "US PM10 breakpoints");
+static_assert(contiguous(caqiPm2p5Hour, 0, 0), "CAQI PM2.5 hourly grid");
+static_assert(contiguous(caqiPm10Hour, 0, 0), "CAQI PM10 hourly grid");
+static_assert(contiguous(caqiPm2p5Day, 0, 0), "CAQI PM2.5 daily grid");
+static_assert(contiguous(caqiPm10Day, 0, 0), "CAQI PM10 daily grid");
+
+// Linear within the band holding conc, rounded. Above the table the US AQI
+// stays at its top (500); CAQI carries on at the slope of its last band, as
+// its grid has no upper end.
+template <uint8_t N>
+static uint16_t interpolate(const aqi_breakpoint_t (&table)[N], uint16_t conc, bool extrapolate) {
+    const aqi_breakpoint_t *band = &table[N - 1];
+    for (uint8_t i = 0; i < N; i++) {
+        if (conc <= table[i].concHi) {
+            band = &table[i];
+            break;
+        }
+    }
+    if (conc > band->concHi && !extrapolate) {
+        return band->indexHi;
+    }
+    uint32_t span = band->concHi - band->concLo;
+    uint32_t index = (uint32_t)(band->indexHi - band->indexLo) * (conc - band->concLo);
+    index = (index + span / 2) / span + band->indexLo;
+    return index > 0xFFFE ? 0xFFFE : (uint16_t)index;
+}
+
+uint16_t aqiUsPm2p5(uint16_t conc) {
+    return conc == AQI_INVALID ? AQI_INVALID : interpolate(usPm2p5, conc, false);
+}
+
+uint16_t aqiUsPm10(uint16_t conc) {
+    // The EPA truncates PM10 to whole ug/m3
+    return conc == AQI_INVALID ? AQI_INVALID : interpolate(usPm10, conc / 10 * 10, false);
+}
+
+static uint16_t higher(uint16_t a, uint16_t b) {
+    if (a == AQI_INVALID) {
+        return b;
+    }
+    if (b == AQI_INVALID) {
+        return a;
+    }
+    return a > b ? a : b;
+}
+
+uint16_t aqiCaqiHourly(uint16_t pm2p5, uint16_t pm10) {
+    return higher(pm2p5 == AQI_INVALID ? AQI_INVALID : interpolate(caqiPm2p5Hour, pm2p5, true),
+                  pm10 == AQI_INVALID ? AQI_INVALID : interpolate(caqiPm10Hour, pm10, true));
+}
+
+uint16_t aqiCaqiDaily(uint16_t pm2p5, uint16_t pm10) {
+    return higher(pm2p5 == AQI_INVALID ? AQI_INVALID : interpolate(caqiPm2p5Day, pm2p5, true),
+                  pm10 == AQI_INVALID ? AQI_INVALID : interpolate(caqiPm10Day, pm10, true));
+}
+
+static constexpr uint16_t categoryTop[AQI_CATEGORIES] = {50, 100, 150, 200, 300, 0xFFFE};
+
+static const char *const categoryNames[AQI_CATEGORIES + 1] = {
+    "good", "moderate", "sensitive", "unhealthy", "very unhealthy", "hazardous", "--"
+};
+
+aqi_category_t aqiUsCategory(uint16_t index) {
+    if (index == AQI_INVALID) {
+        return AQI_CATEGORIES;
+    }
+    uint8_t c = 0;
+    while (index > categoryTop[c]) {
+        c++;
+    }
+    return (aqi_category_t)c;
+}
+
+const char *aqiCategoryName(aqi_category_t category) {
+    return categoryNames[category < AQI_CATEGORIES ? category : AQI_CATEGORIES];
+}
+
+// --- Running means ---
+
+// At least 3/4 of the entries
+#define COMPLETE(valid, total) ((valid) * 4 >= (total) * 3)
+
+void AqiChannel::clear() {
+    memset(this, 0, sizeof(*this));
+    _minuteHeld = AQI_INVALID;
+    _nowCast = AQI_INVALID;
+}
+
+void AqiChannel::rollMinute(bool hourDone) {
+    uint16_t mean = _minuteCount ? (_minuteSum + _minuteCount / 2) / _minuteCount : _minuteHeld;
+    _minuteSum = 0;
+    _minuteCount = 0;
+    _minuteHeld = AQI_INVALID;
+
+    if (_minutesFilled == AQI_HOUR_MINUTES) {
+        uint16_t old = _minutes[_minuteHead];
+        if (old != AQI_INVALID) {
+            _hourSum -= old;
+            _hourValid--;
+        }
+    } else {
+        _minutesFilled++;
+    }
+    _minutes[_minuteHead] = mean;
+    _minuteHead = (_minuteHead + 1) % AQI_HOUR_MINUTES;
+    if (mean != AQI_INVALID) {
+        _hourSum += mean;
+        _hourValid++;
+    }
+
+    if (hourDone) {
+        rollHour();
+    }
+}
+
+uint16_t AqiChannel::hourMean() const {
+    if (!COMPLETE(_hourValid, AQI_HOUR_MINUTES)) {
+        return AQI_INVALID;
+    }
+    return (_hourSum + _hourValid / 2) / _hourValid;
+}
+
+uint16_t AqiChannel::dayMean() const {
+    if (!COMPLETE(_dayValid, AQI_DAY_HOURS)) {
+        return AQI_INVALID;
+    }
+    return (_daySum + _dayValid / 2) / _dayValid;
+}
+
+void AqiChannel::rollHour() {
+    uint16_t mean = hourMean();
+    if (_hoursFilled == AQI_DAY_HOURS) {
+        uint16_t old = _hours[_hourHead];
+        if (old != AQI_INVALID) {
+            _daySum -= old;
+            _dayValid--;
+        }
+    } else {
+        _hoursFilled++;
+    }
+    _hours[_hourHead] = mean;
+    _hourHead = (_hourHead + 1) % AQI_DAY_HOURS;
+    if (mean != AQI_INVALID) {
+        _daySum += mean;
+        _dayValid++;
+    }
+    updateNowCast();
+}
+
+// EPA NowCast over the last 12 hourly means c1 (newest) .. c12: weight
+// factor w = min/max of the valid ones, at least 1/2 for PM, and
+// NowCast = sum(w^(i-1) * ci) / sum(w^(i-1)). Weights in Q16.
+void AqiChannel::updateNowCast() {
+    uint16_t c[AQI_NOWCAST_HOURS];
+    uint8_t n = _hoursFilled < AQI_NOWCAST_HOURS ? _hoursFilled : AQI_NOWCAST_HOURS;
+    uint16_t lo = 0xFFFF;
+    uint16_t hi = 0;
+    uint8_t recent = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        c[i] = _hours[(_hourHead + AQI_DAY_HOURS - 1 - i) % AQI_DAY_HOURS];
+        if (c[i] == AQI_INVALID) {
+            continue;
+        }
+        recent += i < 3;
+        lo = c[i] < lo ? c[i] : lo;
+        hi = c[i] > hi ? c[i] : hi;
+    }
+    if (recent < 2) {
+        _nowCast = AQI_INVALID;
+        return;
+    }
+
+    uint32_t w = hi ? ((uint32_t)lo << 16) / hi : 1u << 16;
+    w = w < (1u << 15) ? 1u << 15 : w;
+    uint64_t sum = 0;
+    uint32_t weights = 0;
+    uint32_t weight = 1u << 16;
+    for (uint8_t i = 0; i < n; i++, weight = (weight * (uint64_t)w) >> 16) {
+        if (c[i] != AQI_INVALID) {
+            sum += (uint64_t)weight * c[i];
+            weights += weight;
+        }
+    }
+    _nowCast = (sum + weights / 2) / weights;
+}
+
+// --- Engine ---
+
+void AqiEngine::clear() {
+    _pm2p5.clear();
+    _pm10.clear();
+    _started = false;
+    _minuteUs = 0;
+    _minute = 0;
+    _coverUs = 0;
+}
+
+void AqiEngine::rollMinute() {
+    _minute = (_minute + 1) % AQI_HOUR_MINUTES;
+    _pm2p5.rollMinute(_minute == 0);
+    _pm10.rollMinute(_minute == 0);
+}
+
+void AqiEngine::advance(uint32_t now) {
+    if (!_started) {
+        return;
+    }
+    uint32_t elapsed = now - _last;
+    _last = now;
+    uint64_t start = AQI_MINUTE_US - _minuteUs; // of the next minute, from the last call
+    _minuteUs += elapsed;
+    // A gap of a day or more empties everything anyway; don't spin through it
+    uint32_t rolls = 0;
+    while (_minuteUs >= AQI_MINUTE_US && rolls++ < AQI_DAY_HOURS * AQI_HOUR_MINUTES) {
+        rollMinute();
+        _minuteUs -= AQI_MINUTE_US;
+        if (start < _coverUs) { // the last reading still stands when this minute starts
+            _pm2p5.hold(_held2p5);
+            _pm10.hold(_held10);
+        }
+        start += AQI_MINUTE_US;
+    }
+    _minuteUs %= AQI_MINUTE_US;
+    _coverUs = elapsed < _coverUs ? _coverUs - elapsed : 0;
+}
+
+void AqiEngine::add(uint32_t now, uint16_t pm2p5, uint16_t pm10, uint32_t coverUs) {
+    if (!_started) {
+        _started = true;
+        _last = now;
+    }
+    advance(now);
+    _pm2p5.add(pm2p5);
+    _pm10.add(pm10);
+    _held2p5 = pm2p5;
+    _held10 = pm10;
+    _coverUs = coverUs;
+}
+
+aqi_t AqiEngine::result() const {
+    aqi_t r;
+    r.pm2p5Hour = _pm2p5.hourMean();
+    r.pm2p5Day = _pm2p5.dayMean();
+    r.pm10Hour = _pm10.hourMean();
+    r.pm10Day = _pm10.dayMean();
+    r.pm2p5NowCast = _pm2p5.nowCast();
+    r.pm10NowCast = _pm10.nowCast();
+    r.us = higher(aqiUsPm2p5(r.pm2p5NowCast), aqiUsPm10(r.pm10NowCast));
+    r.usCategory = aqiUsCategory(r.us);
+    r.caqiHour = aqiCaqiHourly(r.pm2p5Hour, r.pm10Hour);
+    r.caqiDay = aqiCaqiDaily(r.pm2p5Day, r.pm10Day);
+    return r;
+}
@@ -0,0 +1,193 @@
+// enginair bench.cpp
+// On-device microbenchmarks, see bench.h
+
+#include "hal.h"
+#include "bench.h"
+#include "fmt.h"
+#include "sample.h"
+#include "flash_log.h"
+#include "profile.h"
+#include "screen.h"
+#include "stats.h"
+#include "aqi.h"
+
+#define BENCH_ITERATIONS 1000
+
+static volatile uint32_t sink; // keeps results alive
+
+uint32_t benchCycles(void (*fn)(uint32_t i), uint32_t n) {
+    uint32_t start = halCycles();
+    for (uint32_t i = 0; i < n; i++) {
+        fn(i);
+    }
+    return (halCycles() - start) / n;
+}
+
+void benchReport(const char *name, uint32_t cycles) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "bench ");
+    p = fmtStr(p, end, name);
+    p = fmtStr(p, end, ": ");
+    p = fmtUint(p, end, cycles);
+    p = fmtStr(p, end, " cyc");
+    halSerialPrintln(line);
+}
+
+// --- Fixed-point pipeline vs the float path it replaced ---
+// One "sample" is the conversion + formatting of PM2.5, T and RH, as done
+// for every display/serial update.
+
+static uint16_t benchTicks(uint32_t i) {
+    return (uint16_t)(i * 40503u + 12345u); // spread over the whole range
+}
+
+// What SensirionI2CScd4x::readMeasurement and String(x, 1) used to do
+static void sampleFloat(uint32_t i) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    uint16_t ticks = benchTicks(i);
+    float pm = ticks / 10.0f;
+    float temp = -45.0f + 175.0f * ticks / 65536.0f;
+    float humi = 100.0f * ticks / 65536.0f;
+    fmtFloat1(text, end, pm);
+    fmtFloat1(text, end, temp);
+    fmtFloat1(text, end, humi);
+    sink = text[0];
+}
+
+static void sampleFixed(uint32_t i) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    uint16_t ticks = benchTicks(i);
+    fmtFixed1(text, end, ticks);
+    fmtFixed1(text, end, scd4xTempTenths(ticks));
+    fmtFixed1(text, end, scd4xHumiTenths(ticks));
+    sink = text[0];
+}
+
+static void benchFixedPoint() {
+    benchReport("sample float path", benchCycles(sampleFloat, BENCH_ITERATIONS));
+    benchReport("sample fixed path", benchCycles(sampleFixed, BENCH_ITERATIONS));
+}
+
+// --- History codec: cost of compressing one 1 Hz record ---
+
+static uint8_t codecBlock[FLASH_LOG_BLOCK_SIZE];
+static HistoryEncoder codecEncoder;
+
+static void encodeRecord(uint32_t i) {
+    history_record_t record;
+    record.time = i;
+    uint16_t pm = 100 + (benchTicks(i) & 7); // noisy PM, slow CO2/T/RH
+    record.value[CH_PM1P0] = pm - 20;
+    record.value[CH_PM2P5] = pm;
+    record.value[CH_PM4P0] = pm + 5;
+    record.value[CH_PM10P0] = pm + 9;
+    record.value[CH_CO2] = 600 + i / 5 % 16;
+    record.value[CH_TEMP] = 26000 + i / 5 % 32;
+    record.value[CH_HUMI] = 30000 - i / 5 % 32;
+    if (!codecEncoder.add(record)) {
+        codecEncoder.begin(codecBlock, sizeof(codecBlock));
+        codecEncoder.add(record);
+    }
+}
+
+static void benchCodec() {
+    codecEncoder.begin(codecBlock, sizeof(codecBlock));
+    benchReport("history encode", benchCycles(encodeRecord, BENCH_ITERATIONS));
+    sink = codecEncoder.bytes();
+}
+
+// --- Stage profiling: what one timed stage adds (two counter reads and a
+// histogram update). The stage is reset afterwards so the bench doesn't show
+// up in the real figures.
+
+static void profileStage(uint32_t) {
+    uint32_t start = profileStart();
+    profileEnd(PROFILE_OUTPUT, start);
+}
+
+static void benchProfile() {
+    benchReport("profile record", benchCycles(profileStage, BENCH_ITERATIONS));
+    profileReset();
+}
+
+// --- Streaming statistics: what core 0 adds per PM sample (push and
+// summary), for noisy PM and for values spread over the whole range, which
+// moves the most of the sorted median window
+
+static StreamStats benchStats;
+
+static void statsNoisy(uint32_t i) {
+    benchStats.push(100 + (benchTicks(i) & 31));
+    sink = benchStats.summary().median;
+}
+
+static void statsSpread(uint32_t i) {
+    benchStats.push(benchTicks(i));
+    sink = benchStats.summary().median;
+}
+
+static void benchStreamStats() {
+    benchReport("stats pm sample", benchCycles(statsNoisy, BENCH_ITERATIONS));
+    benchStats.clear();
+    benchReport("stats spread sample", benchCycles(statsSpread, BENCH_ITERATIONS));
+}
+
+// --- AQI: the incremental engine against recomputing the means from a
+// buffer of the last hour's samples and the last day's hourly means on each
+// sample (a day of 1 s samples wouldn't fit in RAM). Both feed the same
+// index functions. One bench sample is one second.
+
+#define AQI_BENCH_HOUR 3600
+
+static AqiEngine benchAqi;
+static uint16_t benchHour[2][AQI_BENCH_HOUR];
+static uint16_t benchDay[2][AQI_DAY_HOURS];
+
+static uint16_t benchPm(uint32_t i) {
+    return 80 + (benchTicks(i) & 63);
+}
+
+static void aqiIncremental(uint32_t i) {
+    benchAqi.add(i * 1000000, benchPm(i), benchPm(i) + 40, 1000000);
+    sink = benchAqi.result().us;
+}
+
+static uint16_t bufferMean(const uint16_t *values, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        sum += values[k];
+    }
+    return (sum + n / 2) / n;
+}
+
+static void aqiRecompute(uint32_t i) {
+    benchHour[0][i % AQI_BENCH_HOUR] = benchPm(i);
+    benchHour[1][i % AQI_BENCH_HOUR] = benchPm(i) + 40;
+    uint16_t hour[2];
+    uint16_t day[2];
+    for (uint8_t c = 0; c < 2; c++) {
+        hour[c] = bufferMean(benchHour[c], AQI_BENCH_HOUR);
+        if (i % AQI_BENCH_HOUR == AQI_BENCH_HOUR - 1) {
+            benchDay[c][i / AQI_BENCH_HOUR % AQI_DAY_HOURS] = hour[c];
+        }
+        day[c] = bufferMean(benchDay[c], AQI_DAY_HOURS);
+    }
+    sink = aqiUsPm2p5(hour[0]) + aqiCaqiHourly(hour[0], hour[1]) + aqiCaqiDaily(day[0], day[1]);
+}
+
+static void benchAqiEngine() {
+    benchReport("aqi incremental", benchCycles(aqiIncremental, BENCH_ITERATIONS));
+    benchReport("aqi recompute", benchCycles(aqiRecompute, BENCH_ITERATIONS));
+}
+
+void benchRunAll() {
+    benchFixedPoint();
+    benchCodec();
+    benchProfile();
+    benchStreamStats();
+    benchAqiEngine();
+    screenBench();
+}
@@ -0,0 +1,60 @@
+// enginair boot.cpp
+// Boot timing, see boot.h
+
+#include "hal.h"
+#include "boot.h"
+#include "fmt.h"
+
+static uint32_t stamps[BOOT_STAGES];
+static bool reached[BOOT_STAGES];
+
+static const char *const stageNames[BOOT_STAGES] = {
+    "setup", "sensors issued", "display", "SEN50 started", "SCD40 started", "first PM", "first CO2",
+};
+
+void bootMark(boot_stage_t stage) {
+    if (!reached[stage]) {
+        stamps[stage] = halMicros();
+        reached[stage] = true;
+    }
+}
+
+bool bootReached(boot_stage_t stage) {
+    return reached[stage];
+}
+
+bool bootComplete() {
+    return reached[BOOT_FIRST_PM] && reached[BOOT_FIRST_CO2];
+}
+
+void bootReport() {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    bool printed[BOOT_STAGES] = {};
+
+    // Stages overlap, so print them in the order they actually happened
+    halSerialPrintln("Boot timing (ms since reset, +ms since previous stage):");
+    uint32_t prev = 0;
+    for (;;) {
+        int8_t next = -1;
+        for (uint8_t i = 0; i < BOOT_STAGES; i++) {
+            if (reached[i] && !printed[i] && (next < 0 || stamps[i] < stamps[next])) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        printed[next] = true;
+
+        char *p = fmtStr(line, end, "  ");
+        p = fmtStr(p, end, stageNames[next]);
+        p = fmtStr(p, end, ": ");
+        p = fmtUint(p, end, stamps[next] / 1000);
+        p = fmtStr(p, end, " (+");
+        p = fmtUint(p, end, (stamps[next] - prev) / 1000);
+        p = fmtStr(p, end, ")");
+        halSerialPrintln(line);
+        prev = stamps[next];
+    }
+}
@@ -0,0 +1,85 @@
+// enginair console.cpp
+// Serial command console, see console.h
+
+#include "hal.h"
+#include <string.h>
+#include "console.h"
+#include "fmt.h"
+
+static const console_cmd_t *commandTable = nullptr;
+static uint8_t commandCount = 0;
+static char line[CONSOLE_LINE_SIZE];
+static uint8_t length = 0;
+static bool overflow = false; // drop the rest of an over-long line
+
+void consoleBegin(const console_cmd_t *commands, uint8_t count) {
+    commandTable = commands;
+    commandCount = count;
+}
+
+static void printHelp() {
+    halSerialPrintln("help");
+    for (uint8_t i = 0; i < commandCount; i++) {
+        halSerialPrintln(commandTable[i].help);
+    }
+}
+
+static void runLine() {
+    char *argv[CONSOLE_MAX_ARGS];
+    uint8_t argc = 0;
+
+    char *p = line;
+    while (*p && argc < CONSOLE_MAX_ARGS) {
+        while (*p == ' ') {
+            *p++ = '\0';
+        }
+        if (!*p) {
+            break;
+        }
+        argv[argc++] = p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    if (strcmp(argv[0], "help") == 0) {
+        printHelp();
+        return;
+    }
+    for (uint8_t i = 0; i < commandCount; i++) {
+        if (strcmp(argv[0], commandTable[i].name) == 0) {
+            commandTable[i].fn(argc, argv);
+            return;
+        }
+    }
+    char reply[FMT_LINE_SIZE];
+    p = fmtStr(reply, reply + sizeof(reply), "Unknown command: ");
+    fmtStr(p, reply + sizeof(reply), argv[0]);
+    halSerialPrintln(reply);
+}
+
+bool consolePoll() {
+    bool ran = false;
+    int c;
+    while ((c = halSerialRead()) >= 0) {
+        if (c == '\r' || c == '\n') {
+            if (overflow) {
+                halSerialPrintln("Command too long");
+            } else if (length > 0) {
+                line[length] = '\0';
+                runLine();
+                ran = true;
+            }
+            length = 0;
+            overflow = false;
+        } else if (length < CONSOLE_LINE_SIZE - 1) {
+            line[length++] = (char)c;
+        } else {
+            overflow = true;
+        }
+    }
+    return ran;
+}
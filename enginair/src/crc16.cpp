@@ -0,0 +1,17 @@
+// enginair crc16.cpp
+// CRC-16/CCITT-FALSE, see crc16.h
+
+#include "crc16.h"
+
+#define CRC16_POLY 0x1021
+
+uint16_t crc16(uint16_t crc, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLY : (crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,190 @@
+// enginair flash_log.cpp
+// Log-structured measurement store in flash, see flash_log.h
+
+#include "hal.h"
+#include <stddef.h>
+#include <string.h>
+#include "flash_log.h"
+#include "crc16.h"
+
+#define FLASH_LOG_SECTORS (FLASH_LOG_SIZE / HAL_FLASH_SECTOR_SIZE)
+
+struct flash_sector_t {
+    flash_sector_header_t header;
+    uint8_t block[FLASH_LOG_BLOCK_SIZE];
+};
+
+static_assert(sizeof(flash_sector_t) == HAL_FLASH_SECTOR_SIZE, "sector layout changed");
+
+// RAM image of the sector being filled, programmed as a whole
+static flash_sector_t batch;
+static HistoryEncoder encoder;
+
+static uint16_t recordCounts[FLASH_LOG_SECTORS]; // from the headers
+static bool sectorValid[FLASH_LOG_SECTORS];
+static uint32_t validSectors = 0;  // totals of the two above, kept as sectors
+static uint32_t storedRecords = 0; // are erased and written
+static bool haveNewest = false;
+static uint32_t newestSector = 0;
+static uint32_t nextSector = 0;
+static uint32_t nextSequence = 0;
+static uint32_t boot = 0;
+
+static uint64_t clockUs = 0; // sample time widened past the halMicros() wrap
+static uint32_t lastTime = 0;
+static bool started = false;
+
+static uint32_t writes = 0;
+static uint32_t lastStallUs = 0;
+static uint32_t maxStallUs = 0;
+
+// Flash is memory mapped, reading needs no driver
+static const flash_sector_t *sectorAt(uint32_t index) {
+    return (const flash_sector_t *)(halFlashData() + index * HAL_FLASH_SECTOR_SIZE);
+}
+
+static bool headerValid(const flash_sector_header_t &header) {
+    return header.magic == FLASH_LOG_MAGIC
+        && header.length <= FLASH_LOG_BLOCK_SIZE
+        && header.crc == crc16(CRC16_INIT, &header, offsetof(flash_sector_header_t, crc));
+}
+
+static bool blockValid(const flash_sector_t *sector) {
+    return sector->header.dataCrc == crc16(CRC16_INIT, sector->block, sector->header.length);
+}
+
+void flashLogBegin() {
+    uint32_t newestSequence = 0;
+    uint32_t newestBoot = 0;
+
+    // Headers only: block CRCs are checked when a block is read
+    for (uint32_t s = 0; s < FLASH_LOG_SECTORS; s++) {
+        const flash_sector_header_t &header = sectorAt(s)->header;
+        recordCounts[s] = 0;
+        sectorValid[s] = headerValid(header);
+        if (!sectorValid[s]) {
+            continue; // erased, or the erase/program was cut short
+        }
+        recordCounts[s] = header.count;
+        validSectors++;
+        storedRecords += header.count;
+        if (!haveNewest || (int32_t)(header.sequence - newestSequence) > 0) {
+            haveNewest = true;
+            newestSector = s;
+            newestSequence = header.sequence;
+            newestBoot = header.boot;
+        }
+    }
+
+    if (haveNewest) {
+        nextSector = (newestSector + 1) % FLASH_LOG_SECTORS;
+        nextSequence = newestSequence + 1;
+        boot = newestBoot + 1;
+    }
+    encoder.begin(batch.block, sizeof(batch.block));
+}
+
+void flashLogFlush() {
+    if (encoder.count() == 0) {
+        return;
+    }
+
+    // The encoder zeroes the unused tail; leave it erased instead
+    uint32_t length = encoder.bytes();
+    memset(batch.block + length, 0xFF, sizeof(batch.block) - length);
+
+    flash_sector_header_t &header = batch.header;
+    header.magic = FLASH_LOG_MAGIC;
+    header.sequence = nextSequence;
+    header.boot = boot;
+    header.count = encoder.count();
+    header.length = length;
+    header.dataCrc = crc16(CRC16_INIT, batch.block, length);
+    header.crc = crc16(CRC16_INIT, &header, offsetof(flash_sector_header_t, crc));
+
+    uint32_t start = halMicros();
+    halFlashWriteSector(nextSector * HAL_FLASH_SECTOR_SIZE, (const uint8_t *)&batch);
+    lastStallUs = halMicros() - start;
+    if (lastStallUs > maxStallUs) {
+        maxStallUs = lastStallUs;
+    }
+
+    if (sectorValid[nextSector]) {
+        validSectors--;
+        storedRecords -= recordCounts[nextSector];
+    }
+    sectorValid[nextSector] = true;
+    recordCounts[nextSector] = header.count;
+    validSectors++;
+    storedRecords += header.count;
+    haveNewest = true;
+    newestSector = nextSector;
+    nextSector = (nextSector + 1) % FLASH_LOG_SECTORS;
+    nextSequence++;
+    writes++;
+    encoder.begin(batch.block, sizeof(batch.block));
+}
+
+void flashLogAppend(const sample_t &sample) {
+    if (started) {
+        clockUs += (uint32_t)(sample.time - lastTime);
+    }
+    lastTime = sample.time;
+    started = true;
+
+    history_record_t record;
+    record.time = clockUs / 1000000;
+    historyValues(sample, record.value);
+
+    if (!encoder.add(record)) {
+        flashLogFlush();
+        encoder.add(record);
+    }
+}
+
+bool flashLogGet(uint32_t age, history_record_t &record, uint32_t &recordBoot) {
+    if (!haveNewest) {
+        return false;
+    }
+    // Walk back from the newest sector while the sequence stays unbroken.
+    // A block that fails its CRC is skipped.
+    uint32_t s = newestSector;
+    uint32_t sequence = sectorAt(s)->header.sequence;
+    for (uint32_t i = 0; i < FLASH_LOG_SECTORS; i++) {
+        const flash_sector_t *sector = sectorAt(s);
+        if (!headerValid(sector->header) || sector->header.sequence != sequence) {
+            return false;
+        }
+        uint32_t n = recordCounts[s];
+        if (n > 0 && !blockValid(sector)) {
+            n = 0;
+        }
+        if (age < n) {
+            HistoryDecoder decoder;
+            decoder.begin(sector->block, sector->header.length);
+            for (uint32_t k = 0; k < n - age; k++) {
+                if (!decoder.next(record)) {
+                    return false;
+                }
+            }
+            recordBoot = sector->header.boot;
+            return true;
+        }
+        age -= n;
+        s = (s + FLASH_LOG_SECTORS - 1) % FLASH_LOG_SECTORS;
+        sequence--;
+    }
+    return false;
+}
+
+flash_log_stats_t flashLogStats() {
+    flash_log_stats_t stats = {};
+    stats.sectors = validSectors;
+    stats.records = storedRecords;
+    stats.pending = encoder.count();
+    stats.boot = boot;
+    stats.writes = writes;
+    stats.lastStallUs = lastStallUs;
+    stats.maxStallUs = maxStallUs;
+    return stats;
+}
@@ -0,0 +1,73 @@
+// enginair fmt.cpp
+// Heap-free number formatting, see fmt.h
+
+#include "fmt.h"
+
+// Space for a uint32_t, a sign and a decimal point
+#define FMT_DIGITS_MAX 12
+
+static char *put(char *p, char *end, char c) {
+    if (p + 1 < end) {
+        *p++ = c;
+    }
+    return p;
+}
+
+static char *terminate(char *p, char *end) {
+    if (p < end) {
+        *p = '\0';
+    }
+    return p;
+}
+
+// Digits are produced backwards into tmp, then padded and copied out
+static char *emit(char *p, char *end, const char *digits, uint8_t n, uint8_t width) {
+    for (uint8_t i = n; i < width; i++) {
+        p = put(p, end, ' ');
+    }
+    while (n) {
+        p = put(p, end, digits[--n]);
+    }
+    return terminate(p, end);
+}
+
+char *fmtStr(char *p, char *end, const char *s) {
+    while (*s) {
+        p = put(p, end, *s++);
+    }
+    return terminate(p, end);
+}
+
+char *fmtUint(char *p, char *end, uint32_t value, uint8_t width) {
+    char tmp[FMT_DIGITS_MAX];
+    uint8_t n = 0;
+    do {
+        tmp[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    return emit(p, end, tmp, n, width);
+}
+
+char *fmtFixed1(char *p, char *end, int32_t tenths, uint8_t width) {
+    char tmp[FMT_DIGITS_MAX];
+    uint8_t n = 0;
+    bool negative = tenths < 0;
+    uint32_t value = negative ? -(uint32_t)tenths : tenths;
+
+    tmp[n++] = '0' + value % 10;
+    tmp[n++] = '.';
+    value /= 10;
+    do {
+        tmp[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    if (negative) {
+        tmp[n++] = '-';
+    }
+    return emit(p, end, tmp, n, width);
+}
+
+char *fmtFloat1(char *p, char *end, float value, uint8_t width) {
+    int32_t tenths = (int32_t)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
+    return fmtFixed1(p, end, tenths, width);
+}
@@ -0,0 +1,139 @@
+// enginair hal_rp2040.cpp
+// Hardware abstraction on the RP2040 (arduino-pico + pico-sdk), see hal.h
+
+#include <Arduino.h>
+#include <pico/time.h>
+#include <hardware/timer.h>
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include <pico/mutex.h>
+#include "hal.h"
+
+#define HAL_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - HAL_FLASH_SIZE)
+
+static_assert(HAL_FLASH_SECTOR_SIZE == FLASH_SECTOR_SIZE, "flash sector size");
+
+uint32_t halMicros() {
+    return micros();
+}
+
+uint64_t halMicros64() {
+    return time_us_64();
+}
+
+uint32_t halCycles() {
+    return rp2040.getCycleCount();
+}
+
+uint32_t halCyclesPerMicro() {
+    return rp2040.f_cpu() / 1000000;
+}
+
+void halSleepUntil(uint32_t t) {
+    int32_t wait = (int32_t)(t - micros());
+    if (wait > 0) {
+        best_effort_wfe_or_timeout(make_timeout_time_us(wait));
+    }
+}
+
+void halWaitEvent() {
+    __wfe();
+}
+
+void halSignalEvent() {
+    __sev();
+}
+
+// One of the four timer alarms, claimed on first use (the SDK's alarm pool
+// and arduino-pico keep theirs)
+static int alarmNum = -1;
+static uint32_t alarmDue;
+static uint32_t alarmPeriod;
+static hal_alarm_fn_t alarmFn = nullptr;
+
+// Arm for alarmDue. The alarm compares all 64 bits, so the 32-bit deadline
+// is placed relative to the current 64-bit time.
+static bool alarmArm() {
+    uint64_t now = time_us_64();
+    uint64_t target = now + (int32_t)(alarmDue - (uint32_t)now);
+    return !hardware_alarm_set_target(alarmNum, from_us_since_boot(target)); // true: in the past
+}
+
+static void alarmIrq(uint alarm) {
+    (void)alarm;
+    uint32_t now = timer_hw->timerawl;
+    uint32_t due = alarmDue;
+    do {
+        alarmDue += alarmPeriod;
+    } while ((int32_t)(timer_hw->timerawl - alarmDue) >= 0 || !alarmArm());
+    if (alarmFn) {
+        alarmFn(now, due);
+    }
+    __sev(); // WFE on the other core too
+}
+
+void halAlarmStart(uint32_t first, uint32_t period, hal_alarm_fn_t fn) {
+    if (alarmNum < 0) {
+        alarmNum = hardware_alarm_claim_unused(true);
+        hardware_alarm_set_callback(alarmNum, alarmIrq);
+    }
+    hardware_alarm_cancel(alarmNum);
+    alarmFn = fn;
+    alarmPeriod = period;
+    alarmDue = first;
+    while (!alarmArm()) {
+        alarmDue += alarmPeriod; // first already passed
+    }
+}
+
+void halAlarmStop() {
+    if (alarmNum >= 0) {
+        hardware_alarm_cancel(alarmNum);
+    }
+    alarmFn = nullptr;
+}
+
+// Held for each call's whole output, see hal.h
+auto_init_mutex(serialMutex);
+
+void halSerialBegin() {
+    // Don't wait for a connection, USB enumerates in the background
+    Serial.begin(115200);
+}
+
+void halSerialWrite(const void *data, size_t length) {
+    mutex_enter_blocking(&serialMutex);
+    Serial.write((const uint8_t *)data, length);
+    mutex_exit(&serialMutex);
+}
+
+void halSerialPrintln(const char *text) {
+    mutex_enter_blocking(&serialMutex);
+    Serial.write((const uint8_t *)text, strlen(text));
+    Serial.write((const uint8_t *)"\r\n", 2);
+    mutex_exit(&serialMutex);
+}
+
+int halSerialRead() {
+    return Serial.available() > 0 ? Serial.read() : -1;
+}
+
+bool halSerialConnected() {
+    return (bool)Serial;
+}
+
+const uint8_t *halFlashData() {
+    return (const uint8_t *)(XIP_BASE + HAL_FLASH_OFFSET);
+}
+
+// XIP is off while the flash is busy, so nothing may run from flash: park
+// the other core in RAM and keep interrupts away from this one.
+void halFlashWriteSector(uint32_t offset, const uint8_t *data) {
+    offset += HAL_FLASH_OFFSET;
+    rp2040.idleOtherCore();
+    noInterrupts();
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    flash_range_program(offset, data, FLASH_SECTOR_SIZE);
+    interrupts();
+    rp2040.resumeOtherCore();
+}
@@ -0,0 +1,222 @@
+// enginair history.cpp
+// Multi-tier in-RAM time series, see history.h
+
+#include "history.h"
+#include "ring.h"
+
+struct history_point_t {
+    uint16_t value[HISTORY_CHANNELS];
+};
+
+// Running aggregate of the bucket currently being filled
+struct history_acc_t {
+    uint32_t sum[HISTORY_CHANNELS];
+    uint32_t n[HISTORY_CHANNELS];
+    uint16_t min[HISTORY_CHANNELS];
+    uint16_t max[HISTORY_CHANNELS];
+    uint32_t index; // which bucket (seconds / resolution) this is
+    bool open;
+};
+
+struct history_t {
+    Ring<history_point_t, HISTORY_TIER0_LENGTH> tier0;
+    Ring<history_bucket_t, HISTORY_TIER1_LENGTH> tier1;
+    Ring<history_bucket_t, HISTORY_TIER2_LENGTH> tier2;
+    history_acc_t minute, hour;
+    uint64_t clockUs;  // uptime as seen by the samples, wrap-free
+    uint32_t lastTime; // sample_t.time of the previous sample
+    uint32_t samples;  // added since boot
+    uint32_t interval; // s between the last two samples, rounded
+    bool started;
+};
+
+static history_t history;
+
+static_assert(sizeof(history_t) <= HISTORY_BUDGET_BYTES, "history store over its RAM budget");
+
+static void accReset(history_acc_t &acc, uint32_t index) {
+    for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+        acc.sum[c] = 0;
+        acc.n[c] = 0;
+        acc.min[c] = HISTORY_INVALID;
+        acc.max[c] = 0;
+    }
+    acc.index = index;
+    acc.open = true;
+}
+
+static void accAdd(history_acc_t &acc, uint8_t c, uint16_t min, uint16_t max, uint32_t sum, uint32_t n) {
+    if (n == 0) {
+        return;
+    }
+    acc.sum[c] += sum;
+    acc.n[c] += n;
+    if (min < acc.min[c]) {
+        acc.min[c] = min;
+    }
+    if (max > acc.max[c]) {
+        acc.max[c] = max;
+    }
+}
+
+static history_bucket_t accClose(const history_acc_t &acc) {
+    history_bucket_t bucket;
+    for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+        if (acc.n[c] == 0) {
+            bucket.min[c] = bucket.max[c] = bucket.mean[c] = HISTORY_INVALID;
+            continue;
+        }
+        bucket.min[c] = acc.min[c];
+        bucket.max[c] = acc.max[c];
+        bucket.mean[c] = (acc.sum[c] + acc.n[c] / 2) / acc.n[c];
+    }
+    return bucket;
+}
+
+// Fold a finished minute into the hour, closing the hour first if the
+// minute belongs to the next one
+static void rollMinute() {
+    history_acc_t &minute = history.minute;
+    history_acc_t &hour = history.hour;
+
+    history.tier1.push(accClose(minute));
+
+    uint32_t hourIndex = minute.index * HISTORY_TIER1_SECONDS / HISTORY_TIER2_SECONDS;
+    if (hour.open && hour.index != hourIndex) {
+        history.tier2.push(accClose(hour));
+        hour.open = false;
+    }
+    if (!hour.open) {
+        accReset(hour, hourIndex);
+    }
+    for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+        accAdd(hour, c, minute.min[c], minute.max[c], minute.sum[c], minute.n[c]);
+    }
+}
+
+// No samples from the minute after history.minute up to minuteIndex (a
+// stall, or a POWER_LOW period over a minute): push an empty bucket for
+// each minute and hour skipped, so bucket ages keep matching clock time.
+// Called after rollMinute(), with the hour of the last minute still open.
+static void fillGap(uint32_t minuteIndex) {
+    history_acc_t &hour = history.hour;
+    history_acc_t empty;
+    accReset(empty, 0);
+    history_bucket_t none = accClose(empty);
+
+    uint32_t minutes = minuteIndex - history.minute.index - 1;
+    minutes = minutes < HISTORY_TIER1_LENGTH ? minutes : HISTORY_TIER1_LENGTH;
+    for (uint32_t i = 0; i < minutes; i++) {
+        history.tier1.push(none);
+    }
+
+    uint32_t hourIndex = minuteIndex * HISTORY_TIER1_SECONDS / HISTORY_TIER2_SECONDS;
+    if (hour.index == hourIndex) {
+        return;
+    }
+    history.tier2.push(accClose(hour));
+    hour.open = false;
+    uint32_t hours = hourIndex - hour.index - 1;
+    hours = hours < HISTORY_TIER2_LENGTH ? hours : HISTORY_TIER2_LENGTH;
+    for (uint32_t i = 0; i < hours; i++) {
+        history.tier2.push(none);
+    }
+}
+
+void historyValues(const sample_t &sample, uint16_t value[HISTORY_CHANNELS]) {
+    bool pm = sample.flags & SAMPLE_PM_VALID;
+    bool co2 = sample.flags & SAMPLE_CO2_VALID;
+    value[CH_PM1P0] = pm ? sample.pm1p0 : HISTORY_INVALID;
+    value[CH_PM2P5] = pm ? sample.pm2p5 : HISTORY_INVALID;
+    value[CH_PM4P0] = pm ? sample.pm4p0 : HISTORY_INVALID;
+    value[CH_PM10P0] = pm ? sample.pm10p0 : HISTORY_INVALID;
+    value[CH_CO2] = co2 ? sample.co2 : HISTORY_INVALID;
+    value[CH_TEMP] = co2 ? sample.temp : HISTORY_INVALID;
+    value[CH_HUMI] = co2 ? sample.humi : HISTORY_INVALID;
+}
+
+void historyAdd(const sample_t &sample) {
+    if (history.started) {
+        uint32_t elapsed = sample.time - history.lastTime;
+        history.clockUs += elapsed;
+        history.interval = (elapsed + 500000) / 1000000;
+    }
+    history.lastTime = sample.time;
+    history.started = true;
+    uint32_t seconds = history.clockUs / 1000000;
+
+    history_point_t point;
+    historyValues(sample, point.value);
+    history.tier0.push(point);
+    history.samples++;
+
+    uint32_t minuteIndex = seconds / HISTORY_TIER1_SECONDS;
+    if (history.minute.open && history.minute.index != minuteIndex) {
+        rollMinute();
+        if (minuteIndex - history.minute.index > 1) {
+            fillGap(minuteIndex);
+        }
+        history.minute.open = false;
+    }
+    if (!history.minute.open) {
+        accReset(history.minute, minuteIndex);
+    }
+    for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+        uint16_t v = point.value[c];
+        if (v != HISTORY_INVALID) {
+            accAdd(history.minute, c, v, v, v, 1);
+        }
+    }
+}
+
+uint16_t historyCount(uint8_t tier) {
+    switch (tier) {
+        case 0: return history.tier0.count();
+        case 1: return history.tier1.count();
+        case 2: return history.tier2.count();
+        default: return 0;
+    }
+}
+
+uint32_t historySamples() {
+    return history.samples;
+}
+
+uint32_t historySeconds() {
+    return history.clockUs / 1000000;
+}
+
+uint32_t historyResolution(uint8_t tier) {
+    switch (tier) {
+        case 0: return history.interval ? history.interval : 1;
+        case 1: return HISTORY_TIER1_SECONDS;
+        case 2: return HISTORY_TIER2_SECONDS;
+        default: return 0;
+    }
+}
+
+bool historyGet(uint8_t tier, uint16_t age, history_bucket_t &out) {
+    if (age >= historyCount(tier)) {
+        return false;
+    }
+    switch (tier) {
+        case 0: {
+            const history_point_t &point = history.tier0.get(age);
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                out.min[c] = out.max[c] = out.mean[c] = point.value[c];
+            }
+            return true;
+        }
+        case 1:
+            out = history.tier1.get(age);
+            return true;
+        case 2:
+            out = history.tier2.get(age);
+            return true;
+    }
+    return false;
+}
+
+uint32_t historySize() {
+    return sizeof(history);
+}
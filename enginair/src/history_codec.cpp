@@ -0,0 +1,252 @@
+// enginair history_codec.cpp
+// Delta/XOR bit-stream codec for stored history, see history_codec.h
+
+#include <string.h>
+#include "history_codec.h"
+
+#define VARINT_GROUP_BITS 3
+
+// PM2.5 goes first: the other PM sizes come out of the same particle count,
+// so they are predicted to move by the same amount and only the difference
+// is coded.
+static const uint8_t channelOrder[HISTORY_CHANNELS] = {
+    CH_PM2P5, CH_PM1P0, CH_PM4P0, CH_PM10P0, CH_CO2, CH_TEMP, CH_HUMI
+};
+
+static inline bool isXorChannel(uint8_t c) {
+    return c == CH_TEMP || c == CH_HUMI;
+}
+
+static inline bool followsPm2p5(uint8_t c) {
+    return c == CH_PM1P0 || c == CH_PM4P0 || c == CH_PM10P0;
+}
+
+static inline uint16_t zigzag(int16_t v) {
+    return ((uint16_t)v << 1) ^ (uint16_t)(v >> 15);
+}
+
+static inline int16_t unzigzag(uint16_t v) {
+    return (int16_t)((v >> 1) ^ (uint16_t)-(int16_t)(v & 1));
+}
+
+static inline int32_t signExtend(uint32_t v, uint8_t bits) {
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((v ^ sign) - sign);
+}
+
+static uint8_t leadingZeros16(uint16_t v) {
+    return __builtin_clz(v) - 16; // v != 0
+}
+
+static uint8_t trailingZeros16(uint16_t v) {
+    return __builtin_ctz(v);
+}
+
+static void stateReset(codec_state_t &state) {
+    memset(&state, 0, sizeof(state));
+    for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+        state.lead[c] = 0xFF; // no window yet
+    }
+}
+
+// Time delta-of-delta size classes, as in Gorilla
+struct dod_class_t {
+    uint8_t prefix;     // value of the prefix bits
+    uint8_t prefixBits;
+    uint8_t bits;       // payload, two's complement
+};
+static const dod_class_t dodClasses[] = {
+    {0x2, 2, 7},
+    {0x6, 3, 9},
+    {0xE, 4, 12},
+};
+#define DOD_RAW_PREFIX 0xF
+#define DOD_RAW_PREFIX_BITS 4
+
+// --- Encoder ---
+
+void HistoryEncoder::begin(uint8_t *buffer, uint32_t size) {
+    _buffer = buffer;
+    _size = size;
+    _bit = 0;
+    _count = 0;
+    memset(buffer, 0, size);
+    stateReset(_state);
+}
+
+// MSB first. The buffer starts zeroed, so only the set bits are written.
+void HistoryEncoder::put(uint32_t value, uint8_t bits) {
+    for (int8_t i = bits - 1; i >= 0; i--) {
+        if ((value >> i) & 1) {
+            _buffer[_bit >> 3] |= 0x80 >> (_bit & 7);
+        }
+        _bit++;
+    }
+}
+
+bool HistoryEncoder::add(const history_record_t &record) {
+    if (_bit + CODEC_MAX_RECORD_BITS > _size * 8) {
+        return false;
+    }
+
+    int32_t delta = (int32_t)(record.time - _state.time);
+    int32_t dod = delta - _state.timeDelta;
+    if (dod == 0) {
+        put(0, 1);
+    } else {
+        bool packed = false;
+        for (const dod_class_t &cls : dodClasses) {
+            int32_t limit = 1 << (cls.bits - 1);
+            if (dod >= -limit && dod < limit) {
+                put(cls.prefix, cls.prefixBits);
+                put((uint32_t)dod & ((1u << cls.bits) - 1), cls.bits);
+                packed = true;
+                break;
+            }
+        }
+        if (!packed) {
+            put(DOD_RAW_PREFIX, DOD_RAW_PREFIX_BITS);
+            put((uint32_t)dod, 32);
+        }
+    }
+    _state.time = record.time;
+    _state.timeDelta = delta;
+
+    uint16_t pmStep = record.value[CH_PM2P5] - _state.value[CH_PM2P5];
+    for (uint8_t c : channelOrder) {
+        uint16_t value = record.value[c];
+        if (isXorChannel(c)) {
+            uint16_t x = value ^ _state.value[c];
+            if (x == 0) {
+                put(0, 1);
+            } else {
+                uint8_t lead = leadingZeros16(x);
+                uint8_t trail = trailingZeros16(x);
+                if (_state.lead[c] != 0xFF && lead >= _state.lead[c] && trail >= _state.trail[c]) {
+                    put(0x2, 2);
+                    put(x >> _state.trail[c], 16 - _state.lead[c] - _state.trail[c]);
+                } else {
+                    uint8_t length = 16 - lead - trail;
+                    put(0x3, 2);
+                    put(lead, 4);
+                    put(length - 1, 4);
+                    put(x >> trail, length);
+                    _state.lead[c] = lead;
+                    _state.trail[c] = trail;
+                }
+            }
+        } else {
+            uint16_t predicted = _state.value[c] + (followsPm2p5(c) ? pmStep : 0);
+            uint16_t z = zigzag((int16_t)(value - predicted));
+            if (z == 0) {
+                put(0, 1);
+            } else {
+                put(1, 1);
+                z--;
+                do {
+                    uint8_t group = z & ((1 << VARINT_GROUP_BITS) - 1);
+                    z >>= VARINT_GROUP_BITS;
+                    put(z ? 1 : 0, 1);
+                    put(group, VARINT_GROUP_BITS);
+                } while (z);
+            }
+        }
+        _state.value[c] = value;
+    }
+
+    _count++;
+    return true;
+}
+
+// --- Decoder ---
+
+void HistoryDecoder::begin(const uint8_t *buffer, uint32_t size) {
+    _buffer = buffer;
+    _size = size;
+    _bit = 0;
+    _overrun = false;
+    stateReset(_state);
+}
+
+// Past the end of the data, reads zeros and flags the record as bad
+uint32_t HistoryDecoder::get(uint8_t bits) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bits; i++) {
+        uint32_t bit = 0;
+        if (_bit < _size * 8) {
+            bit = (_buffer[_bit >> 3] >> (7 - (_bit & 7))) & 1;
+        } else {
+            _overrun = true;
+        }
+        value = (value << 1) | bit;
+        _bit++;
+    }
+    return value;
+}
+
+bool HistoryDecoder::next(history_record_t &record) {
+    int32_t dod = 0;
+    if (get(1)) {
+        uint8_t prefix = 1;
+        uint8_t prefixBits = 1;
+        bool packed = false;
+        for (const dod_class_t &cls : dodClasses) {
+            while (prefixBits < cls.prefixBits) {
+                prefix = (prefix << 1) | get(1);
+                prefixBits++;
+            }
+            if (prefix == cls.prefix) {
+                dod = signExtend(get(cls.bits), cls.bits);
+                packed = true;
+                break;
+            }
+        }
+        if (!packed) {
+            dod = (int32_t)get(32);
+        }
+    }
+    _state.timeDelta += dod;
+    _state.time += _state.timeDelta;
+    record.time = _state.time;
+
+    uint16_t pmStep = 0;
+    for (uint8_t c : channelOrder) {
+        uint16_t value = _state.value[c];
+        if (isXorChannel(c)) {
+            if (get(1)) {
+                if (get(1) == 0) {
+                    uint8_t length = 16 - _state.lead[c] - _state.trail[c];
+                    value ^= get(length) << _state.trail[c];
+                } else {
+                    uint8_t lead = get(4);
+                    uint8_t length = get(4) + 1;
+                    uint8_t trail = 16 - lead - length;
+                    value ^= get(length) << trail;
+                    _state.lead[c] = lead;
+                    _state.trail[c] = trail;
+                }
+            }
+        } else {
+            if (followsPm2p5(c)) {
+                value += pmStep;
+            }
+            if (get(1)) {
+                uint16_t z = 0;
+                uint8_t shift = 0;
+                bool more;
+                do {
+                    more = get(1);
+                    z |= get(VARINT_GROUP_BITS) << shift;
+                    shift += VARINT_GROUP_BITS;
+                } while (more);
+                value += unzigzag(z + 1);
+            }
+            if (c == CH_PM2P5) {
+                pmStep = value - _state.value[c];
+            }
+        }
+        _state.value[c] = value;
+        record.value[c] = value;
+    }
+    return !_overrun;
+}
@@ -0,0 +1,38 @@
+// enginair i2c_bus.cpp
+// Shared I2C bus on Wire with a cross-core lock, see i2c_bus.h
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <pico/mutex.h>
+#include "i2c_bus.h"
+
+auto_init_mutex(busMutex);
+
+void i2cBusInit() {
+    Wire.setSCL(I2C_SCL_PIN);
+    Wire.setSDA(I2C_SDA_PIN);
+    Wire.begin();
+    Wire.setClock(I2C_SENSOR_CLOCK);
+}
+
+void i2cBusLock() {
+    mutex_enter_blocking(&busMutex);
+}
+
+void i2cBusUnlock() {
+    mutex_exit(&busMutex);
+}
+
+uint8_t i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+    Wire.beginTransmission(address);
+    Wire.write(data, length);
+    return Wire.endTransmission();
+}
+
+uint8_t i2cRead(uint8_t address, uint8_t *data, uint8_t length) {
+    uint8_t n = Wire.requestFrom(address, (size_t)length);
+    for (uint8_t i = 0; i < n; i++) {
+        data[i] = Wire.read();
+    }
+    return n;
+}
@@ -2,303 +2,1097 @@
 // Read Particulate matter (PM), CO2, Temperature and humidity from SEN50 and SCD40 sensors.
 // Display on an SSD1306 128x32 OLED.
 
-#include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include "symbols.h"
-#include <SensirionI2CSen5x.h>
-#include <SensirionI2CScd4x.h>
-
-#define DISPLAY_WIDTH 128
-#define DISPLAY_HEIGHT 32
-#define DISPLAY_ADDRESS 0x3C
-Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1); // -1: no reset pin
-#include <Fonts/FreeSans9pt7b.h> // TODO: Convert Meshtastic font ArialMT_Plain_10 to Adafruit GFX font
-// Meshtastic FONT_MEDIUM = ArialMT_Plain_16, FONT_SMALL = ArialMT_Plain_10
-
-SensirionI2CSen5x pmSens;
-SensirionI2CScd4x co2Sens;
-
-// TODO: figure out how to pass in a TwoWire pointer
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "screen.h"
+#include "sen50.h"
+#include "scd40.h"
+#include "scd40_phase.h"
+#include "scheduler.h"
+#include "sample.h"
+#include "spsc_queue.h"
+#include "i2c_bus.h"
+#include "oled.h"
+#include "fmt.h"
+#include "bench.h"
+#include "boot.h"
+#include "history.h"
+#include "console.h"
+#include "flash_log.h"
+#include "telemetry.h"
+#include "profile.h"
+#include "trace.h"
+#include "stats.h"
+#include "aqi.h"
+#include "sample_clock.h"
+#include "power.h"
+
+// Build check: the loop path must not touch the heap. Any use of String below
+// this line (e.g. String(x, 1)) is a compile error; format with fmt.h instead.
+#pragma GCC poison String
+
+Sen50 pmSens;
+Scd40 co2Sens;
+Scd40Phase co2Phase; // decides when to read the SCD40, see scd40_phase.h
+StreamStats pmStats; // PM2.5, fed by pollSensors()
+AqiEngine aqiEngine; // PM2.5 and PM10, fed by pollSensors()
+
 void initSEN50();
 void initSCD40();
-void printSensirionError(String message, uint16_t error);
-
-#define PROJECT_NAME "enginAIR"
-enum message_t {
-    DEBUG,
-    NAME,
-    INFO,
-    WARN,
-    ERR
+void pollSensors();
+void printSensirionError(const char *message, uint16_t error);
+void printCO2BusStats();
+
+void printPMValues(uint32_t time, uint16_t pm1p0, uint16_t pm2p5, uint16_t pm4p0, uint16_t pm10p0,
+                   const stats_summary_t &stats);
+void printCO2Values(uint32_t time, uint16_t co2, int16_t temp, uint16_t humi);
+
+// Serial console commands (core 1)
+void cmdHistory(uint8_t argc, char **argv);
+void cmdLog(uint8_t argc, char **argv);
+void cmdOutput(uint8_t argc, char **argv);
+void cmdProfile(uint8_t argc, char **argv);
+void cmdCapture(uint8_t argc, char **argv);
+void cmdStats(uint8_t argc, char **argv);
+void cmdAqi(uint8_t argc, char **argv);
+void cmdScreen(uint8_t argc, char **argv);
+void cmdPower(uint8_t argc, char **argv);
+const console_cmd_t commands[] = {
+    {"history", cmdHistory, "history [tier 0-2] [count] [pm1|pm2.5|pm4|pm10|co2|temp|humi]"},
+    {"log", cmdLog, "log [flush | dump [count]]"},
+    {"output", cmdOutput, "output [text | binary]"},
+    {"profile", cmdProfile, "profile [reset | <stage>]"},
+    {"capture", cmdCapture, "capture [on | off]"},
+    {"stats", cmdStats, "stats [raw|fast|mid|slow|min|max|median|p90]"},
+    {"aqi", cmdAqi, "aqi"},
+    {"screen", cmdScreen, "screen [auto|values|pm|climate|aqi|trend|sweep|stats]"},
+    {"power", cmdPower, "power [normal | low [period s] [warmup s] | display <s>]"},
 };
 
-bool initDisplay();
-void showMessage(String message, message_t level);
-void showPMValues(float pm1p0, float pm2p5, float pm4p0, float pm10p0);
-void showCO2Values(uint16_t co2, float temp, float humi);
-void showValues_LargeText(float pm2p5, uint16_t co2, float temp, float humi);
+// PM2.5 statistic shown on the display and in the text output, and the
+// newest statistics for the console (core 1)
+stats_view_t pmView = STATS_RAW;
+stats_summary_t latestPmStats = {};
+aqi_t latestAqi;
 
-void setup() {
-    Wire.setSCL(17);
-    Wire.setSDA(16);
-    Wire.begin();
+// What loop1 draws (console "screen"): a fixed screen, or the carousel,
+// which moves on with the first sample at least CAROUSEL_US after the
+// current screen came up. Timed, not counted in samples, so at a POWER_LOW
+// period of CAROUSEL_US or more every sample shows the next screen.
+#define CAROUSEL_US 5000000
+enum screen_choice_t {
+    SCREEN_AUTO,
+    SCREEN_VALUES,
+    SCREEN_PM,
+    SCREEN_CLIMATE,
+    SCREEN_AQI,
+    SCREEN_TREND, // showTrend(TREND_SCROLL)
+    SCREEN_SWEEP, // showTrend(TREND_SWEEP)
+    SCREEN_STATS,
+    SCREEN_CHOICES
+};
+const char *const screenNames[SCREEN_CHOICES] = {
+    "auto", "values", "pm", "climate", "aqi", "trend", "sweep", "stats"};
+const screen_choice_t carousel[] = {SCREEN_VALUES, SCREEN_PM, SCREEN_CLIMATE, SCREEN_AQI, SCREEN_TREND,
+                                    SCREEN_STATS};
+screen_choice_t screenChoice = SCREEN_AUTO;
+uint8_t carouselIndex = 0;
+void showScreen(screen_choice_t screen, const sample_t &sample, int16_t temp, uint16_t humi);
 
-    initDisplay(); // OLED display init early, so we can show a message
-    Serial.begin(115200);
+// Power mode (power.h). The console (core 1) owns powerConfig and hands
+// each change to core 0 through powerRequests; core 0 applies it to the
+// sensors and the sample clock (applyPower) and keeps its own copy. Build
+// env:rpipico_battery (ENGINAIR_LOW_POWER) to start in POWER_LOW.
+#ifdef ENGINAIR_LOW_POWER
+#define POWER_DEFAULT_MODE POWER_LOW
+#else
+#define POWER_DEFAULT_MODE POWER_NORMAL
+#endif
+const power_config_t powerDefault = {POWER_DEFAULT_MODE, POWER_LOW_PERIOD_S, POWER_WARMUP_S,
+                                     POWER_DISPLAY_TIMEOUT_S};
+power_config_t powerConfig = powerDefault;  // core 1
+power_config_t powerApplied = powerDefault; // core 0
+SpscQueue<power_config_t, 2> powerRequests;
+power_usage_t powerSince = {}; // start of what "power" reports: the last change
+void applyPower(const power_config_t &config);
 
-    showMessage("Waiting for serial", NAME);
-    while (!Serial) {
-        delay(100);
-        break; // don't wait 
-    }
-    showMessage("Connected", NAME);
+// Display blanking (core 1): in POWER_LOW the panel goes off displayTimeout
+// after the last console command and on again with the next one. Nothing
+// is drawn while it is off.
+bool displayOn = true;
+uint64_t lastCommand = 0;
+void updateDisplayPower(bool command);
+
+// Core 0 does acquisition, core 1 does rendering and serial output. Samples
+// go from one to the other through this queue, so a slow display flush can
+// never hold up a sensor read.
+SpscQueue<sample_t, 8> sampleQueue;
+volatile bool bootDone = false; // core 1 leaves the display alone until set
+
+// Acquisition (core 0). Samples are paced by the sample clock: its alarm
+// interrupt stamps each tick, and loop() starts the SEN50 read for it (see
+// sampleTick). The scheduler tasks share the same timebase. The read only
+// kicks off the sensor command; the sample is published once the slowest
+// read (SEN5x, 20 ms) has had time to complete. The SCD40 task has no fixed
+// period: co2Phase moves its deadline to just after each expected sample.
+// In POWER_LOW the SEN50 idles after each tick's reading until the pmwake
+// task starts it again, warmup seconds before the next tick.
+void sampleTick(const sample_tick_t &tick);
+void taskBoot();
+void taskSCD40();
+void taskPublish();
+void taskPMWake();
+void publish(uint32_t time);
+void preview(uint32_t time);
+
+#define SAMPLE_PERIOD_US 1000000
+#define PUBLISH_DELAY_US 50000
+#define BOOT_POLL_US 100000
+#define BOOT_TIMEOUT_US 15000000 // give up fast polling if a sensor never answers
+#define CO2_STATS_EVERY 60 // print SCD40 bus savings every this many samples
 
+enum task_id_t { TASK_BOOT, TASK_SCD40, TASK_PUBLISH, TASK_PM_WAKE };
+// scd40: this period only until the sensor has started. publish: moved by
+// each tick; pmwake: moved by each tick in POWER_LOW. The last three fields
+// are set by schedulerStart().
+task_t tasks[] = {
+    // name     fn           period            offset
+    {"boot",    taskBoot,    BOOT_POLL_US,     0,                                   0, 0, false},
+    {"scd40",   taskSCD40,   SCD40_PERIOD_US,  SCD40_PERIOD_US,                     0, 0, false},
+    {"publish", taskPublish, SAMPLE_PERIOD_US, SAMPLE_PERIOD_US + PUBLISH_DELAY_US, 0, 0, false},
+    {"pmwake",  taskPMWake,  SAMPLE_PERIOD_US, SAMPLE_PERIOD_US,                    0, 0, false},
+};
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+
+void setup() {
+    bootMark(BOOT_SETUP);
+    i2cBusInit();
+
+    // Kick off the sensor resets first. They settle in the background while
+    // the display and serial come up, and loop() picks them up from there.
     initSEN50(); // PM sensor init
     initSCD40(); // CO2 sensor init
+    bootMark(BOOT_SENSORS_ISSUED);
+
+    initDisplay(); // OLED display init early, so we can show a message
+    powerSetActive(POWER_OLED, true);
+    bootMark(BOOT_DISPLAY_READY);
 
-    showMessage("Init complete", NAME);
-    Serial.println("Starting main loop");
+    halSerialBegin();
+
+#ifdef ENGINAIR_BENCH
+    benchRunAll();
+#endif
+
+    showMessage("Waiting for sensors", NAME);
+    halSerialPrintln("Starting main loop");
+    bootDone = true;
+    schedulerStart(tasks, TASK_COUNT);
+    applyPower(powerApplied); // starts the sample clock
 }
 
-int seconds = 0;
+// Latest readings, owned by core 0
+sample_t current = {};
+
+uint32_t sampleTime = 0; // tick the current readings were requested on
+bool pmSampleDue = false; // the SEN50 read in flight is a tick's, not the boot task's
+
 void loop() {
-    uint16_t error;
-    char errorMessage[256];
-    float pm1p0, pm2p5, pm4p0, pm10p0, sen_temp, nox, voc, sen_humi;
-
-    delay(1000);
-    seconds++;
-
-    error = pmSens.readMeasuredValues(pm1p0, pm2p5, pm4p0, pm10p0, sen_humi, sen_temp, voc, nox);
-    if (error) {
-        printSensirionError("Error reading measured values from SEN50: ", error);
-    } else { 
-        // showPMValues(pm1p0, pm2p5, pm4p0, pm10p0);
-
-        // SEN50 has no VOC, NOx, humidity or temperature sensor.
-    }
-
-    // The SCD40 CO2 sensor only produces a new measurement every 5 seconds, 
-    // and clears the buffer after reading, so check if data is ready
-    uint16_t co2;
-    float temp, humi;
-    bool dataReady = false;
-    error = co2Sens.getDataReadyFlag(dataReady);
-    if (error) {
-        printSensirionError("Couldn't get SCD40 data ready flag: ", error);
-        return; // Don't do anything after this if an error occurred at this stage
-    }
-    
-    // Serial.print("Data ready: ");
-    // Serial.println(dataReady);
-    if (dataReady) {
-        error = co2Sens.readMeasurement(co2, temp, humi);
-        if (error) {
-            printSensirionError("Error reading measurement from SCD40: ", error);
-        } else {
-            // showCO2Values(co2, temp, humi);
-        }
+    uint32_t awake = halMicros();
+    sample_tick_t tick;
+    if (sampleClockTake(tick)) {
+        sampleTick(tick);
     }
+    schedulerRun();
+    pollSensors();
 
-    // // Swap between the CO2 and PM values every 5 seconds
-    // if (seconds > 5) {
-    //     showCO2Values(co2, temp, humi);
-    // } else {
-    //     showPMValues(pm1p0, pm2p5, pm4p0, pm10p0);
-    // }
-    showValues_LargeText(pm2p5, co2, temp, humi);
+    // A new power mode waits until neither sensor has a command in flight
+    power_config_t config;
+    if (!pmSens.busy() && !co2Sens.busy() && powerRequests.pop(config)) {
+        applyPower(config);
+    }
+    powerAddActive(POWER_CORE0, halMicros() - awake);
+    schedulerIdle();
+}
 
-    if (seconds >= 10) {
-        seconds = 0;
+// Switch to config: the sample clock and the tasks paced by it, the SCD40
+// measurement mode (a restart, so ~0.5 s without readings) and whether the
+// SEN50 idles between samples. The display is left to core 1.
+void applyPower(const power_config_t &config) {
+    bool low = config.mode == POWER_LOW;
+    if (low != co2Sens.lowPower()) {
+        co2Sens.begin(low);
+    }
+    if (!powerPmDutyCycled(config)) {
+        pmSens.startMeasurement(); // if idle
     }
+    powerApplied = config;
+    uint32_t period = powerSamplePeriodUs(config);
+    tasks[TASK_PUBLISH].period_us = period;
+    tasks[TASK_PM_WAKE].period_us = period;
+    sampleClockStart(halMicros() + period, period);
 }
 
-void initSEN50() {
-    pmSens.begin(Wire);
-
-    uint16_t error;
-    char message[256];
-    error = pmSens.deviceReset();
-    if (error) {
-        printSensirionError("Error resetting SEN50: ", error);
-    } 
-
-    error = pmSens.startMeasurement();
-    if (error) {
-        printSensirionError("Error starting SEN50 measurement: ", error);
-    } else {
-        Serial.println("SEN50 measurement started successfully");
+// Until the first PM value is in, ask the SEN50 every 100 ms instead of
+// waiting for its normal cadence (the SCD40 task polls by itself until it
+// has locked on). Each first value is published the moment it arrives (see
+// pollSensors), so the display fills in as soon as it can.
+void taskBoot() {
+    if (bootComplete() || schedulerTickTime() > BOOT_TIMEOUT_US) {
+        bootReport();
+        schedulerStopCurrent();
+        return;
+    }
+    if (pmSens.measuring() && !bootReached(BOOT_FIRST_PM)) {
+        pmSens.requestRead(true);
     }
 }
 
-void initSCD40() {
-    co2Sens.begin(Wire);
+// Read the SEN50 PM values for a sample clock tick (1 Hz, or the POWER_LOW
+// period), and publish them PUBLISH_DELAY_US after its deadline. The sample
+// is stamped with the time the alarm fired, not when the loop got round to
+// it.
+void sampleTick(const sample_tick_t &tick) {
+    uint32_t start = profileStart();
+    sampleTime = tick.time;
+    profileRecordMicros(PROFILE_START, halMicros() - tick.due);
+    pmSens.requestRead();
+    pmSampleDue = true;
+    schedulerSetDeadline(tasks[TASK_PUBLISH], tick.due + PUBLISH_DELAY_US);
+    if (powerPmDutyCycled(powerApplied)) {
+        schedulerSetDeadline(tasks[TASK_PM_WAKE],
+                             tick.due + powerSamplePeriodUs(powerApplied) - powerApplied.warmup * 1000000u);
+    }
+    profileEnd(PROFILE_SEN50, start);
+}
+
+// POWER_LOW: start the SEN50 measuring again, so it has warmed up by the
+// next tick. Not needed otherwise; sampleTick() restarts it when it is.
+void taskPMWake() {
+    if (!powerPmDutyCycled(powerApplied)) {
+        schedulerStopCurrent();
+        return;
+    }
+    pmSens.startMeasurement();
+}
 
-    // A measurement might be running from a previous startup
-    uint16_t error;
-    char message[256];
-    error = co2Sens.stopPeriodicMeasurement();
-    if (error) {
-        printSensirionError("Error stopping SCD40 measurement: ", error);
+// The SCD40 CO2 sensor only produces a new measurement every 5 seconds, 
+// and clears the buffer after reading. co2Phase decides whether to check
+// the data ready flag first or read straight away; the next deadline is set
+// by pollSensors() once the outcome is known.
+void taskSCD40() {
+    if (!co2Sens.measuring()) {
+        return;
+    }
+    uint32_t start = profileStart();
+    co2Sens.requestRead(co2Phase.nextRequest());
+    profileEnd(PROFILE_SCD40, start);
+}
+
+// Advance both sensor state machines and collect whatever has finished.
+// Called on every pass of loop(), i.e. at each task deadline and each time a
+// sensor command's execution time runs out. Only polls that did something
+// are profiled, the rest are a timestamp compare.
+void pollSensors() {
+    uint32_t now = halMicros();
+
+    uint32_t start = profileStart();
+    driver_event_t event = pmSens.poll(now);
+    switch (event) {
+        case DRIVER_STARTED:
+            powerSetActive(POWER_SEN50, true);
+            if (!bootReached(BOOT_SEN50_STARTED)) { // not each POWER_LOW wake-up
+                bootMark(BOOT_SEN50_STARTED);
+                halSerialPrintln("SEN50 measurement started successfully");
+            }
+            break;
+        case DRIVER_SAMPLE: {
+            bool tickRead = pmSampleDue;
+            pmSampleDue = false;
+            if (pmSens.pm2p5 == SEN5X_PM_INVALID) {
+                current.flags &= ~SAMPLE_PM_VALID; // still warming up, not last cycle's values
+                break;
+            }
+            current.pm1p0 = pmSens.pm1p0;
+            current.pm2p5 = pmSens.pm2p5;
+            current.pm4p0 = pmSens.pm4p0;
+            current.pm10p0 = pmSens.pm10p0;
+            current.flags |= SAMPLE_PM_VALID;
+            pmStats.push(current.pm2p5);
+            current.pm2p5Stats = pmStats.summary();
+            aqiEngine.add(now, current.pm2p5, current.pm10p0, powerSamplePeriodUs(powerApplied));
+            current.aqi = aqiEngine.result();
+            if (!bootReached(BOOT_FIRST_PM)) {
+                bootMark(BOOT_FIRST_PM);
+                preview(now);
+            }
+            if (tickRead && powerPmDutyCycled(powerApplied)) {
+                pmSens.stopMeasurement(); // idle until taskPMWake
+                powerSetActive(POWER_SEN50, pmSens.measuring());
+            }
+            break;
+        }
+        case DRIVER_ERROR:
+            printSensirionError(pmSens.errorContext, pmSens.error);
+            if (pmSens.measuring()) {
+                current.flags &= ~SAMPLE_PM_VALID;
+            }
+            break;
+        default:
+            break;
+    }
+    if (event != DRIVER_NONE) {
+        profileEnd(PROFILE_SEN50, start);
     }
 
-    error = co2Sens.startPeriodicMeasurement();
-    if (error) {
-        printSensirionError("Error starting SCD40 measurement: ", error);
+    start = profileStart();
+    event = co2Sens.poll(now);
+    switch (event) {
+        case DRIVER_STARTED: {
+            bootMark(BOOT_SCD40_STARTED);
+            halSerialPrintln(co2Sens.lowPower() ? "SCD40 low power measurement started successfully"
+                                                : "SCD40 measurement started successfully");
+            powerSetActive(POWER_SCD40, !co2Sens.lowPower());
+            // The first sample takes a full period; start looking shortly before
+            uint32_t period = co2Sens.lowPower() ? SCD40_LOW_POWER_PERIOD_US : SCD40_PERIOD_US;
+            co2Phase.begin(now, period);
+            schedulerSetDeadline(tasks[TASK_SCD40], now + period - SCD40_PROBE_LEAD_US);
+            break;
+        }
+        case DRIVER_SAMPLE:
+            current.co2 = co2Sens.co2;
+            current.temp = co2Sens.temp;
+            current.humi = co2Sens.humi;
+            current.flags |= SAMPLE_CO2_VALID | SAMPLE_CO2_NEW;
+            if (!bootReached(BOOT_FIRST_CO2)) {
+                bootMark(BOOT_FIRST_CO2);
+                preview(now);
+            }
+            schedulerSetDeadline(tasks[TASK_SCD40], co2Phase.onSample(now));
+            if (co2Phase.stats(now).samples % CO2_STATS_EVERY == 0) {
+                printCO2BusStats();
+            }
+            break;
+        case DRIVER_NOT_READY:
+            schedulerSetDeadline(tasks[TASK_SCD40], co2Phase.onNotReady(now));
+            break;
+        case DRIVER_ERROR:
+            printSensirionError(co2Sens.errorContext, co2Sens.error);
+            if (co2Sens.measuring()) {
+                schedulerSetDeadline(tasks[TASK_SCD40], co2Phase.onNotReady(now));
+            }
+            break;
+        default:
+            break;
+    }
+    if (event != DRIVER_NONE) {
+        profileEnd(PROFILE_SCD40, start);
+    }
+}
+
+void taskPublish() {
+    publish(sampleTime);
+}
+
+// Hand a snapshot to core 1. Never waits: if core 1 has fallen behind, the
+// sample is dropped (and counted by the queue).
+void publish(uint32_t time) {
+    current.time = time;
+    sampleQueue.push(current);
+    current.flags &= ~SAMPLE_CO2_NEW;
+    halSignalEvent(); // wake core 1
+}
+
+// Show the first readings as soon as they arrive, rather than up to a
+// period later. Only the display takes them; history, the log and the
+// output keep to the tick grid, and the next tick publishes as usual.
+void preview(uint32_t time) {
+    sample_t sample = current;
+    sample.time = time;
+    sample.flags |= SAMPLE_PREVIEW;
+    sampleQueue.push(sample);
+    halSignalEvent();
+}
+
+void setup1() {
+    flashLogBegin();
+    consoleBegin(commands, sizeof(commands) / sizeof(commands[0]));
+}
+
+uint32_t carouselShown = 0; // sample_t.time the current carousel screen came up
+sample_t latestSample; // to redraw when the display comes back on
+bool haveSample = false;
+void loop1() {
+    uint32_t awake = halMicros();
+    sample_t sample;
+    if (bootDone) {
+        oledPoll(); // next run of a frame on the wire
+        updateDisplayPower(consolePoll());
+        tracePoll();
+    }
+    if (!bootDone || !sampleQueue.pop(sample)) {
+        powerAddActive(POWER_CORE1, halMicros() - awake);
+        halWaitEvent();
+        return;
+    }
+
+    bool onGrid = !(sample.flags & SAMPLE_PREVIEW);
+    uint32_t start = profileStart();
+    if (onGrid) {
+        historyAdd(sample);
+        flashLogAppend(sample);
+    }
+    profileEnd(PROFILE_STORE, start);
+
+    latestPmStats = sample.pm2p5Stats;
+    latestAqi = sample.aqi;
+    latestSample = sample;
+    haveSample = true;
+    int16_t temp = scd4xTempTenths(sample.temp);
+    uint16_t humi = scd4xHumiTenths(sample.humi);
+    if (displayOn) {
+        screen_choice_t screen = screenChoice;
+        if (screen == SCREEN_AUTO) {
+            if (onGrid && sample.time - carouselShown >= CAROUSEL_US) {
+                carouselShown = sample.time;
+                carouselIndex = (carouselIndex + 1) % (sizeof(carousel) / sizeof(carousel[0]));
+            }
+            screen = carousel[carouselIndex];
+        }
+        start = profileStart();
+        showScreen(screen, sample, temp, humi);
+        profileEnd(PROFILE_DRAW, start);
+    }
+
+    if (!onGrid) {
+        powerAddActive(POWER_CORE1, halMicros() - awake);
+        return;
+    }
+    start = profileStart();
+    if (telemetryBinary()) {
+        telemetrySample(sample);
     } else {
-        Serial.println("SCD40 measurement started successfully");
+        if (sample.flags & SAMPLE_PM_VALID) {
+            printPMValues(sample.time, sample.pm1p0, sample.pm2p5, sample.pm4p0, sample.pm10p0,
+                          sample.pm2p5Stats);
+        }
+        if (sample.flags & SAMPLE_CO2_VALID) {
+            printCO2Values(sample.time, sample.co2, temp, humi);
+        }
     }
+    profileEnd(PROFILE_OUTPUT, start);
+    powerAddActive(POWER_CORE1, halMicros() - awake);
 }
 
-// Print an error message and a decoded Sensirion error code
-void printSensirionError(String message, uint16_t error) {
-    char errorMessage[256];
-    errorToString(error, errorMessage, 256);
-    Serial.print(message);
-    Serial.println(errorMessage);
-}
-
-// Initialise the SSD1306 OLED display settings and display a small message
-bool initDisplay() {
-    if(!display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS)) {
-        Serial.println(F("Couldn't initialise SSD1306"));
-        return false;
-    }
-
-    display.setTextSize(1);
-    // TODO: Uncomment when font fixed
-    //display.setFont(&FreeSans9pt7b);
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); // foreground, background
-    display.setCursor(0, 20);
-    display.println("display init...");
-    display.display();
-
-    return true;
-}
-
-// Display a short message on the OLED display (and Serial) with a "log level"
-void showMessage(String message, message_t level) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0,0);
-    
-    switch (level) {
-        case DEBUG:
-            display.println("DEBUG: ");
-            Serial.print("DEBUG: ");
+// Switch the panel off once the timeout has run out since the last command
+// (or the last mode change), and back on for a new one, redrawing the newest
+// sample rather than leaving the one from before until the next tick
+void updateDisplayPower(bool command) {
+    uint64_t now = halMicros64();
+    if (command) {
+        lastCommand = now;
+    }
+    bool on = powerConfig.mode != POWER_LOW || powerConfig.displayTimeout == 0
+              || now - lastCommand < powerConfig.displayTimeout * 1000000ull;
+    if (on == displayOn) {
+        return;
+    }
+    displayOn = on;
+    oledSetPower(on);
+    powerSetActive(POWER_OLED, on);
+    if (on && haveSample) {
+        screen_choice_t screen = screenChoice == SCREEN_AUTO ? carousel[carouselIndex] : screenChoice;
+        showScreen(screen, latestSample, scd4xTempTenths(latestSample.temp), scd4xHumiTenths(latestSample.humi));
+    }
+}
+
+// Draw one screen for the newest sample
+void showScreen(screen_choice_t screen, const sample_t &sample, int16_t temp, uint16_t humi) {
+    switch (screen) {
+        case SCREEN_AUTO:
+        case SCREEN_VALUES:
+        case SCREEN_CHOICES:
+            showValues_LargeText(statsView(sample.pm2p5Stats, pmView, sample.pm2p5), sample.co2, temp, humi,
+                                 sample.flags);
+            break;
+        case SCREEN_PM:
+            showPMValues(sample.pm1p0, sample.pm2p5, sample.pm4p0, sample.pm10p0, sample.flags);
             break;
-        case INFO:
-            display.println("INFO: ");
-            Serial.print("INFO: ");
+        case SCREEN_CLIMATE:
+            showCO2Values(sample.co2, temp, humi, sample.flags);
             break;
-        case WARN:
-            display.println("WARN: ");
-            Serial.print("WARN: ");
+        case SCREEN_AQI:
+            showAQIValues(sample.aqi);
             break;
-        case ERR:
-            display.println("ERROR: ");
-            Serial.print("ERROR: ");
+        case SCREEN_TREND:
+        case SCREEN_SWEEP:
+            showTrend(screen == SCREEN_SWEEP ? TREND_SWEEP : TREND_SCROLL);
             break;
-        case NAME:
-            display.print(PROJECT_NAME);
-            display.println(": ");
-            Serial.print(PROJECT_NAME);
-            Serial.print(": ");
+        case SCREEN_STATS: {
+            flash_log_stats_t log = flashLogStats();
+            screen_stats_t stats;
+            stats.uptime = historySeconds();
+            stats.boot = log.boot;
+            stats.records = log.records + log.pending;
+            stats.dropped = sampleQueue.dropped();
+            showStats(stats);
             break;
+        }
+    }
+}
+
+// Start the PM sensor: reset, then start measurement. Progress and errors
+// are reported by pollSensors().
+void initSEN50() {
+    pmSens.begin();
+}
+
+// Start the CO2 sensor, in the power mode's measurement mode. A measurement
+// might be running from a previous startup, so the driver stops it first.
+void initSCD40() {
+    co2Sens.begin(powerApplied.mode == POWER_LOW);
+}
+
+// Print how many SCD40 commands the predictive read scheduling has saved
+// (in binary mode, a stats frame with those and the queue/display counters)
+void printCO2BusStats() {
+    scd40_bus_stats_t stats = co2Phase.stats(halMicros());
+    if (telemetryBinary()) {
+        oled_stats_t oled = oledStats();
+        telemetry_stats_t body;
+        body.time = halMicros();
+        body.queueDropped = sampleQueue.dropped();
+        body.co2Checks = stats.checks;
+        body.co2Reads = stats.reads;
+        body.co2Saved = stats.saved;
+        body.co2Misses = stats.misses;
+        body.oledFrames = oled.frames;
+        body.oledSkipped = oled.skipped;
+        telemetrySend(TELEMETRY_STATS, &body, sizeof(body));
+        return;
+    }
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "SCD40 bus: ");
+    p = fmtUint(p, end, stats.checks + stats.reads);
+    p = fmtStr(p, end, " cmds (");
+    p = fmtUint(p, end, stats.checks);
+    p = fmtStr(p, end, " checks), saved ");
+    p = fmtUint(p, end, stats.saved);
+    p = fmtStr(p, end, " of ");
+    p = fmtUint(p, end, stats.baseline);
+    p = fmtStr(p, end, ", misses ");
+    p = fmtUint(p, end, stats.misses);
+    p = fmtStr(p, end, ", probes ");
+    p = fmtUint(p, end, stats.probes);
+    p = fmtStr(p, end, ", period ");
+    p = fmtUint(p, end, stats.period);
+    p = fmtStr(p, end, " us");
+    halSerialPrintln(line);
+}
+
+// Print an error message and a decoded Sensirion error code
+void printSensirionError(const char *message, uint16_t error) {
+    if (telemetryBinary()) {
+        telemetryError(message, error);
+        return;
+    }
+    char line[FMT_LINE_SIZE];
+    char *p = fmtStr(line, line + sizeof(line), message);
+    fmtStr(p, line + sizeof(line), sensirionErrorString(error));
+    halSerialPrintln(line);
+}
+
+// Print the PM values on the serial monitor, stamped with the tick time, and
+// the selected PM2.5 statistic if there is one
+void printPMValues(uint32_t time, uint16_t pm1p0, uint16_t pm2p5, uint16_t pm4p0, uint16_t pm10p0,
+                   const stats_summary_t &stats) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtUint(line, end, time / 1000);
+    p = fmtStr(p, end, "ms\t PM1.0: ");
+    p = fmtFixed1(p, end, pm1p0);
+    p = fmtStr(p, end, "\t PM2.5: ");
+    p = fmtFixed1(p, end, pm2p5);
+    p = fmtStr(p, end, "\t PM4.0: ");
+    p = fmtFixed1(p, end, pm4p0);
+    p = fmtStr(p, end, "\t PM10.0: ");
+    p = fmtFixed1(p, end, pm10p0);
+    if (pmView != STATS_RAW && stats.count) {
+        p = fmtStr(p, end, "\t PM2.5 ");
+        p = fmtStr(p, end, statsViewName(pmView));
+        p = fmtStr(p, end, ": ");
+        p = fmtFixed1(p, end, statsView(stats, pmView, pm2p5));
+    }
+    halSerialPrintln(line);
+}
+
+// Print the CO2 ppm, temperature and humidity on the serial monitor
+void printCO2Values(uint32_t time, uint16_t co2, int16_t temp, uint16_t humi) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtUint(line, end, time / 1000);
+    p = fmtStr(p, end, "ms\t CO2: ");
+    p = fmtUint(p, end, co2);
+    p = fmtStr(p, end, "\t Temperature: ");
+    p = fmtFixed1(p, end, temp);
+    p = fmtStr(p, end, "\t Humidity: ");
+    p = fmtFixed1(p, end, humi);
+    halSerialPrintln(line);
+}
+
+
+// History query. Without arguments, lists the tiers. With a channel, prints
+// min/mean/max of that channel per bucket, otherwise the mean of every
+// channel. Newest bucket first, stamped with its age in seconds.
+static const char *const channelNames[HISTORY_CHANNELS] = {
+    "pm1", "pm2.5", "pm4", "pm10", "co2", "temp", "humi"
+};
+#define HISTORY_DEFAULT_ROWS 10
+
+char *fmtChannel(char *p, char *end, uint8_t channel, uint16_t value) {
+    if (value == HISTORY_INVALID) {
+        return fmtStr(p, end, NO_VALUE);
+    }
+    switch (channel) {
+        case CH_CO2:
+            return fmtUint(p, end, value);
+        case CH_TEMP:
+            return fmtFixed1(p, end, scd4xTempTenths(value));
+        case CH_HUMI:
+            return fmtFixed1(p, end, scd4xHumiTenths(value));
         default:
-            display.println("(no msg type): ");
-    }
-
-    display.println(message);
-    display.display();
-
-    // print to serial, for good measure
-    Serial.println(message);
-}
-
-#define BOTLINE_Y 29
-#define TOPLINE_Y 14
-#define RIGHTHALF_X 64
-void showValues_LargeText(float pm2p5, uint16_t co2, float temp, float humi) {
-    int x, y; // temp vars
-    display.clearDisplay();
-    display.setFont(&FreeSans9pt7b);
-    display.setTextSize(1);
-    display.setCursor(0,TOPLINE_Y);
-    display.print(String(pm2p5, 1));
-
-    display.setFont(); // reset to default font
-    x = display.getCursorX();
-    display.drawBitmap(x+2, 0, icon_ugm3, 16, 16, SSD1306_WHITE);
-
-    display.setFont(&FreeSans9pt7b);
-    display.setCursor(RIGHTHALF_X, TOPLINE_Y);
-    display.print(co2);
-    display.setFont();
-    display.setCursor(display.getCursorX()+1, display.getCursorY());
-    display.print("ppm");
-
-    display.setFont(&FreeSans9pt7b);
-    display.setCursor(0, BOTLINE_Y);
-    display.print(String(temp, 1));
-    x = display.getCursorX();
-    y = display.getCursorY();
-    display.drawBitmap(x+1, y-10, icon_degC, 8, 7, SSD1306_WHITE);
-    display.setCursor(RIGHTHALF_X, BOTLINE_Y);
-    display.print(String(humi, 1));
-    display.print("%");
-    display.display();
-}
-
-// Show the PM values on the OLED and serial monitor
-void showPMValues(float pm1p0, float pm2p5, float pm4p0, float pm10p0) {
-    Serial.print("PM1.0: ");
-    Serial.print(pm1p0);
-    Serial.print("\t PM2.5: ");
-    Serial.print(pm2p5);
-    Serial.print("\t PM4.0: ");
-    Serial.print(pm4p0);
-    Serial.print("\t PM10.0: ");
-    Serial.print(pm10p0);
-    Serial.println();
-
-    // Only show PM2.5 and PM10 for brevity
-    display.clearDisplay();
-    display.setCursor(16,0);
-    display.drawBitmap(0, 0, icon_pm25, 16, 7, SSD1306_WHITE);
-    display.print(pm2p5);
-    display.println(" ug/m3");
-    display.setCursor(16, 10);
-    display.drawBitmap(0, 10, icon_pm10, 16, 7, SSD1306_WHITE);
-    display.print(pm10p0);
-    display.print(" ug/m3");
-    display.display();
-}
-
-// Show the CO2 ppm, temperature and humidity on the OLED and serial monitor
-void showCO2Values(uint16_t co2, float temp, float humi) {
-    Serial.print("CO2: ");
-    Serial.print(co2);
-    Serial.print("\t Temperature: ");
-    Serial.print(temp);
-    Serial.print("\t Humidity: ");
-    Serial.print(humi);
-    Serial.println();
-
-    display.clearDisplay();
-    display.setCursor(0,0);
-    display.print("CO2: ");
-    display.print(co2);
-    display.print(" ppm");
-    display.setCursor(0,10);
-    display.print("Temp: ");
-    display.print(temp);
-    display.print("C");
-    display.setCursor(0,20);
-    display.print("Humidity: ");
-    display.print(humi);
-    display.print("%");
-    display.display();
-}
\ No newline at end of file
+            return fmtFixed1(p, end, value); // PM, already tenths
+    }
+}
+
+void cmdHistory(uint8_t argc, char **argv) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p;
+
+    if (argc < 2) {
+        for (uint8_t tier = 0; tier < HISTORY_TIERS; tier++) {
+            p = fmtStr(line, end, "tier ");
+            p = fmtUint(p, end, tier);
+            p = fmtStr(p, end, ": ");
+            p = fmtUint(p, end, historyCount(tier));
+            p = fmtStr(p, end, " x ");
+            p = fmtUint(p, end, historyResolution(tier));
+            p = fmtStr(p, end, " s");
+            halSerialPrintln(line);
+        }
+        p = fmtUint(line, end, historySize());
+        p = fmtStr(p, end, " bytes");
+        halSerialPrintln(line);
+        return;
+    }
+
+    uint8_t tier = strtoul(argv[1], nullptr, 10);
+    if (tier >= HISTORY_TIERS) {
+        halSerialPrintln("No such tier");
+        return;
+    }
+    uint16_t rows = argc > 2 ? strtoul(argv[2], nullptr, 10) : HISTORY_DEFAULT_ROWS;
+    int8_t channel = -1;
+    if (argc > 3) {
+        for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+            if (strcmp(argv[3], channelNames[c]) == 0) {
+                channel = c;
+            }
+        }
+        if (channel < 0) {
+            halSerialPrintln("No such channel");
+            return;
+        }
+    }
+
+    history_bucket_t bucket;
+    for (uint16_t age = 0; age < rows && historyGet(tier, age, bucket); age++) {
+        p = fmtStr(line, end, "-");
+        p = fmtUint(p, end, (uint32_t)age * historyResolution(tier));
+        p = fmtStr(p, end, "s");
+        if (channel >= 0) {
+            p = fmtStr(p, end, "\t");
+            p = fmtChannel(p, end, channel, bucket.min[channel]);
+            p = fmtStr(p, end, "\t");
+            p = fmtChannel(p, end, channel, bucket.mean[channel]);
+            p = fmtStr(p, end, "\t");
+            p = fmtChannel(p, end, channel, bucket.max[channel]);
+        } else {
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                p = fmtStr(p, end, "\t");
+                p = fmtStr(p, end, channelNames[c]);
+                p = fmtStr(p, end, " ");
+                p = fmtChannel(p, end, c, bucket.mean[c]);
+            }
+        }
+        halSerialPrintln(line);
+    }
+}
+
+// Flash log status, or flush the RAM batch, or print the newest records
+// (boot number, seconds since that boot, then every channel)
+#define LOG_DEFAULT_ROWS 10
+void cmdLog(uint8_t argc, char **argv) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p;
+
+    if (argc > 1 && strcmp(argv[1], "flush") == 0) {
+        flashLogFlush();
+    } else if (argc > 1 && strcmp(argv[1], "dump") == 0) {
+        uint32_t rows = argc > 2 ? strtoul(argv[2], nullptr, 10) : LOG_DEFAULT_ROWS;
+        history_record_t record;
+        uint32_t boot;
+        for (uint32_t age = 0; age < rows && flashLogGet(age, record, boot); age++) {
+            p = fmtUint(line, end, boot);
+            p = fmtStr(p, end, ":");
+            p = fmtUint(p, end, record.time);
+            p = fmtStr(p, end, "s");
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                p = fmtStr(p, end, "\t");
+                p = fmtChannel(p, end, c, record.value[c]);
+            }
+            halSerialPrintln(line);
+        }
+        return;
+    } else if (argc > 1) {
+        halSerialPrintln("Unknown log command");
+        return;
+    }
+
+    flash_log_stats_t stats = flashLogStats();
+    p = fmtStr(line, end, "log: boot ");
+    p = fmtUint(p, end, stats.boot);
+    p = fmtStr(p, end, ", ");
+    p = fmtUint(p, end, stats.records);
+    p = fmtStr(p, end, " records in ");
+    p = fmtUint(p, end, stats.sectors);
+    p = fmtStr(p, end, " sectors, ");
+    p = fmtUint(p, end, stats.pending);
+    p = fmtStr(p, end, " pending, ");
+    p = fmtUint(p, end, stats.writes);
+    p = fmtStr(p, end, " writes, stall ");
+    p = fmtUint(p, end, stats.lastStallUs);
+    p = fmtStr(p, end, " us (max ");
+    p = fmtUint(p, end, stats.maxStallUs);
+    p = fmtStr(p, end, ")");
+    halSerialPrintln(line);
+}
+
+// Switch the sample/error/stats output between text and binary frames
+void cmdOutput(uint8_t argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "binary") == 0) {
+        telemetryMode = TELEMETRY_BINARY;
+    } else if (argc > 1 && strcmp(argv[1], "text") == 0) {
+        telemetryMode = TELEMETRY_TEXT;
+    } else if (argc > 1) {
+        halSerialPrintln("Unknown output mode");
+        return;
+    }
+    halSerialPrintln(telemetryBinary() ? "output binary" : "output text");
+}
+
+// Stage latency table with the sample clock's tick count, or one stage's
+// histogram, or clear them all. Times are in microseconds.
+char *fmtCyclesUs(char *p, char *end, uint32_t cycles) {
+    return fmtFixed1(p, end, (uint64_t)cycles * 10 / halCyclesPerMicro());
+}
+
+void cmdProfile(uint8_t argc, char **argv) {
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        profileReset();
+        halSerialPrintln("profile reset");
+        return;
+    }
+    if (argc > 1) {
+        int8_t stage = -1;
+        for (uint8_t s = 0; s < PROFILE_STAGES; s++) {
+            if (strcmp(argv[1], profileStageName((profile_stage_t)s)) == 0) {
+                stage = s;
+            }
+        }
+        if (stage < 0) {
+            halSerialPrintln("No such stage");
+            return;
+        }
+        for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+            uint32_t count = profileBucketCount((profile_stage_t)stage, b);
+            if (count == 0) {
+                continue;
+            }
+            p = fmtCyclesUs(line, end, profileBucketLow(b));
+            p = fmtStr(p, end, "..");
+            p = fmtCyclesUs(p, end, profileBucketLow(b + 1));
+            p = fmtStr(p, end, " us\t");
+            p = fmtUint(p, end, count);
+            halSerialPrintln(line);
+        }
+        return;
+    }
+
+    halSerialPrintln("stage\tcount\tmin\tp50\tp99\tmax\tover (budget)");
+    for (uint8_t s = 0; s < PROFILE_STAGES; s++) {
+        profile_summary_t summary;
+        p = fmtStr(line, end, profileStageName((profile_stage_t)s));
+        if (!profileSummary((profile_stage_t)s, summary)) {
+            fmtStr(p, end, "\t0");
+            halSerialPrintln(line);
+            continue;
+        }
+        p = fmtStr(p, end, "\t");
+        p = fmtUint(p, end, summary.count);
+        p = fmtStr(p, end, "\t");
+        p = fmtCyclesUs(p, end, summary.min);
+        p = fmtStr(p, end, "\t");
+        p = fmtCyclesUs(p, end, summary.p50);
+        p = fmtStr(p, end, "\t");
+        p = fmtCyclesUs(p, end, summary.p99);
+        p = fmtStr(p, end, "\t");
+        p = fmtCyclesUs(p, end, summary.max);
+        p = fmtStr(p, end, "\t");
+        p = fmtUint(p, end, summary.overruns);
+        p = fmtStr(p, end, " (");
+        p = fmtUint(p, end, profileBudgetUs((profile_stage_t)s));
+        p = fmtStr(p, end, ")");
+        halSerialPrintln(line);
+    }
+
+    // alarm and start above are its jitter
+    sample_clock_stats_t clock = sampleClockStats();
+    p = fmtStr(line, end, "sample clock: ");
+    p = fmtUint(p, end, clock.ticks);
+    p = fmtStr(p, end, " ticks of ");
+    p = fmtUint(p, end, clock.period);
+    p = fmtStr(p, end, " us, ");
+    p = fmtUint(p, end, clock.missed);
+    p = fmtStr(p, end, " missed");
+    halSerialPrintln(line);
+}
+
+// Sensor traffic capture (trace.h). Switching it on mid-run streams the
+// traffic, but only a capture from reset can be replayed.
+void cmdCapture(uint8_t argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "on") == 0) {
+        traceCapture = true;
+    } else if (argc > 1 && strcmp(argv[1], "off") == 0) {
+        traceCapture = false;
+    } else if (argc > 1) {
+        halSerialPrintln("Unknown capture command");
+        return;
+    }
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, traceCapture ? "capture on" : "capture off");
+    p = fmtStr(p, end, ", dropped ");
+    p = fmtUint(p, end, traceDropped());
+    halSerialPrintln(line);
+}
+
+// PM2.5 statistics of the newest sample, and the one shown in place of the
+// raw value. Binary output always carries all of them (TELEMETRY_PM_STATS).
+void cmdStats(uint8_t argc, char **argv) {
+    if (argc > 1) {
+        int8_t view = -1;
+        for (uint8_t v = 0; v < STATS_VIEWS; v++) {
+            if (strcmp(argv[1], statsViewName((stats_view_t)v)) == 0) {
+                view = v;
+            }
+        }
+        if (view < 0) {
+            halSerialPrintln("No such statistic");
+            return;
+        }
+        pmView = (stats_view_t)view;
+    }
+
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "pm2.5 shows ");
+    p = fmtStr(p, end, statsViewName(pmView));
+    halSerialPrintln(line);
+
+    const stats_summary_t &stats = latestPmStats;
+    if (stats.count == 0) {
+        halSerialPrintln("no PM samples yet");
+        return;
+    }
+    p = line;
+    for (uint8_t v = STATS_FAST; v < STATS_VIEWS; v++) {
+        p = fmtStr(p, end, statsViewName((stats_view_t)v));
+        p = fmtStr(p, end, " ");
+        p = fmtFixed1(p, end, statsView(stats, (stats_view_t)v, 0));
+        p = fmtStr(p, end, v + 1 < STATS_VIEWS ? "\t" : "");
+    }
+    halSerialPrintln(line);
+}
+
+// Air quality indices of the newest sample (aqi.h)
+char *fmtPm(char *p, char *end, uint16_t ticks) {
+    return ticks == AQI_INVALID ? fmtStr(p, end, NO_VALUE) : fmtFixed1(p, end, ticks);
+}
+
+char *fmtIndex(char *p, char *end, uint16_t index) {
+    return index == AQI_INVALID ? fmtStr(p, end, NO_VALUE) : fmtUint(p, end, index);
+}
+
+void cmdAqi(uint8_t argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    const aqi_t &aqi = latestAqi;
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "US AQI ");
+    p = fmtIndex(p, end, aqi.us);
+    p = fmtStr(p, end, " (");
+    p = fmtStr(p, end, aqiCategoryName((aqi_category_t)aqi.usCategory));
+    p = fmtStr(p, end, "), CAQI 1h ");
+    p = fmtIndex(p, end, aqi.caqiHour);
+    p = fmtStr(p, end, " 24h ");
+    p = fmtIndex(p, end, aqi.caqiDay);
+    halSerialPrintln(line);
+
+    halSerialPrintln("\t1h\t24h\tNowCast");
+    p = fmtStr(line, end, "pm2.5\t");
+    p = fmtPm(p, end, aqi.pm2p5Hour);
+    p = fmtStr(p, end, "\t");
+    p = fmtPm(p, end, aqi.pm2p5Day);
+    p = fmtStr(p, end, "\t");
+    p = fmtPm(p, end, aqi.pm2p5NowCast);
+    halSerialPrintln(line);
+    p = fmtStr(line, end, "pm10\t");
+    p = fmtPm(p, end, aqi.pm10Hour);
+    p = fmtStr(p, end, "\t");
+    p = fmtPm(p, end, aqi.pm10Day);
+    p = fmtStr(p, end, "\t");
+    p = fmtPm(p, end, aqi.pm10NowCast);
+    halSerialPrintln(line);
+}
+
+// Pick the screen, and say what the panel traffic has been so far (pixel
+// bytes per frame sent tells what a trend point costs on the bus)
+void cmdScreen(uint8_t argc, char **argv) {
+    if (argc > 1) {
+        int8_t choice = -1;
+        for (uint8_t c = 0; c < SCREEN_CHOICES; c++) {
+            if (strcmp(argv[1], screenNames[c]) == 0) {
+                choice = c;
+            }
+        }
+        if (choice < 0) {
+            halSerialPrintln("No such screen");
+            return;
+        }
+        screenChoice = (screen_choice_t)choice;
+    }
+
+    oled_stats_t oled = oledStats();
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "screen ");
+    p = fmtStr(p, end, screenNames[screenChoice]);
+    p = fmtStr(p, end, ", oled ");
+    p = fmtUint(p, end, oled.frames);
+    p = fmtStr(p, end, " frames ");
+    p = fmtUint(p, end, oled.bytes);
+    p = fmtStr(p, end, " bytes ");
+    p = fmtUint(p, end, oled.skipped);
+    p = fmtStr(p, end, " skipped");
+    halSerialPrintln(line);
+}
+
+// Set the power mode, or the display timeout (which core 1 handles by
+// itself). Then print the mode, and each component's duty cycle and
+// estimated average current since the mode last changed.
+void cmdPower(uint8_t argc, char **argv) {
+    power_config_t config = powerConfig;
+    if (argc > 1 && strcmp(argv[1], "normal") == 0) {
+        config.mode = POWER_NORMAL;
+    } else if (argc > 1 && strcmp(argv[1], "low") == 0) {
+        config.mode = POWER_LOW;
+        unsigned long period = argc > 2 ? strtoul(argv[2], nullptr, 10) : config.period;
+        unsigned long warmup = argc > 3 ? strtoul(argv[3], nullptr, 10) : config.warmup;
+        if (period < 1 || period > POWER_MAX_PERIOD_S) {
+            halSerialPrintln("Period out of range");
+            return;
+        }
+        // The SEN50 starts warmup s before the tick, so that has to fall
+        // inside the period
+        if (warmup < 1 || warmup >= period) {
+            halSerialPrintln("Warmup out of range (1 s to the period)");
+            return;
+        }
+        config.period = period;
+        config.warmup = warmup;
+    } else if (argc > 2 && strcmp(argv[1], "display") == 0) {
+        config.displayTimeout = strtoul(argv[2], nullptr, 10);
+    } else if (argc > 1) {
+        halSerialPrintln("Unknown power command");
+        return;
+    }
+
+    if (config.mode != powerConfig.mode || config.period != powerConfig.period
+        || config.warmup != powerConfig.warmup) {
+        if (!powerRequests.push(config)) {
+            halSerialPrintln("Previous power change still pending");
+            return;
+        }
+        halSignalEvent(); // wake core 0 to apply it
+        powerSince = powerUsage();
+    }
+    powerConfig = config;
+
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, config.mode == POWER_LOW ? "power low, a sample every " : "power normal");
+    if (config.mode == POWER_LOW) {
+        p = fmtUint(p, end, config.period);
+        p = fmtStr(p, end, " s, sen50 ");
+        if (powerPmDutyCycled(config)) {
+            p = fmtStr(p, end, "warmup ");
+            p = fmtUint(p, end, config.warmup);
+            p = fmtStr(p, end, " s");
+        } else {
+            p = fmtStr(p, end, "always on");
+        }
+        p = fmtStr(p, end, ", display ");
+        if (config.displayTimeout) {
+            p = fmtStr(p, end, "off after ");
+            p = fmtUint(p, end, config.displayTimeout);
+            p = fmtStr(p, end, " s");
+        } else {
+            p = fmtStr(p, end, "always on");
+        }
+    }
+    halSerialPrintln(line);
+
+    power_usage_t now = powerUsage();
+    p = fmtStr(line, end, "over the last ");
+    p = fmtUint(p, end, (now.time - powerSince.time) / 1000000);
+    p = fmtStr(p, end, " s:");
+    halSerialPrintln(line);
+    halSerialPrintln("part\tduty %\tactive ms\tavg mA");
+    uint32_t total = 0;
+    for (uint8_t c = 0; c < POWER_COMPONENTS; c++) {
+        power_component_t component = (power_component_t)c;
+        uint32_t ua = powerAverageUa(powerSince, now, component);
+        total += ua;
+        p = fmtStr(line, end, powerComponentName(component));
+        p = fmtStr(p, end, "\t");
+        p = fmtFixed1(p, end, powerDuty(powerSince, now, component));
+        p = fmtStr(p, end, "\t");
+        p = fmtUint(p, end, (now.active[c] - powerSince.active[c]) / 1000);
+        p = fmtStr(p, end, "\t\t");
+        p = fmtFixed1(p, end, ua / 100);
+        halSerialPrintln(line);
+    }
+    p = fmtStr(line, end, "total\t\t\t\t");
+    p = fmtFixed1(p, end, total / 100);
+    halSerialPrintln(line);
+}
@@ -0,0 +1,310 @@
+// enginair oled.cpp
+// DMA-driven SSD1306 framebuffer flush, see oled.h
+
+#include <Arduino.h>
+#include <hardware/dma.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+#include "oled.h"
+#include "i2c_bus.h"
+#include "hal.h"
+#include "profile.h"
+
+#define SSD1306_CTRL_CMD 0x00
+#define SSD1306_CTRL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_CHARGEPUMP 0x8D
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+// Every byte on the wire is one 16-bit IC_DATA_CMD word, so the STOP bit can
+// ride along with the last byte of each transaction. After a STOP the
+// controller issues a fresh START for the next word by itself, which lets a
+// single DMA transfer carry several transactions.
+//
+// The bus is shared with the sensors on core 0, so it is only held for one
+// column run (its window commands plus at most a page of data, ~3 ms at
+// 400 kHz) at a time. The interrupt at the end of a run gives the bus back;
+// oledPoll() takes it again for the next one, which lets a waiting sensor
+// transaction in between.
+#define OLED_I2C i2c0
+
+// Only columns that differ from what the panel already shows are sent, as
+// runs of columns per page. Each run costs 8 words of addressing overhead,
+// so two runs closer than that are merged.
+#define OLED_RANGE_OVERHEAD 8
+#define OLED_RANGE_GAP OLED_RANGE_OVERHEAD
+#define OLED_MAX_RANGES ((OLED_WIDTH + OLED_RANGE_GAP) / (OLED_RANGE_GAP + 1) + 1)
+#define OLED_WIRE_WORDS (OLED_PAGES * (OLED_WIDTH + OLED_RANGE_OVERHEAD * OLED_MAX_RANGES))
+#define OLED_MAX_RUNS (OLED_PAGES * OLED_MAX_RANGES)
+
+// One half of the double buffer: a full copy of the frame, plus the word
+// stream that moves the changed parts of it onto the panel, split into runs
+struct wire_buffer_t {
+    uint8_t frame[OLED_BUFFER_SIZE];
+    uint16_t words[OLED_WIRE_WORDS];
+    uint16_t runEnd[OLED_MAX_RUNS]; // word index just past each run
+    uint8_t runs;
+};
+
+static wire_buffer_t wireBuffers[2];
+static int dmaChannel = -1;
+static spin_lock_t *stateLock; // the state below is shared with the IRQ, which may be on the other core
+static volatile int8_t onWire = -1;  // wire buffer being sent, -1 if idle
+static volatile uint8_t run = 0;     // next (or current) run of onWire
+static volatile bool sending = false; // a run is on the wire and the bus is held
+static volatile int8_t pending = -1; // wire buffer waiting for the bus
+static volatile int8_t shown = 0;    // frame the panel holds once onWire is done
+static volatile bool fullRefresh = true; // panel contents unknown (boot, abort)
+static oled_done_fn_t doneFn = nullptr;
+static uint32_t wireStart; // halMicros(), the IRQ may run on the other core
+
+// Statistics, each counter written on one side only
+static volatile uint32_t framesSent = 0; // IRQ
+static volatile uint32_t aborts = 0;     // IRQ
+static uint32_t replaced = 0;            // flushing core
+static uint32_t skipped = 0;
+static uint32_t bytesSent = 0;
+
+// Build one "command" transaction followed by one "data" transaction
+static uint16_t *appendCommands(uint16_t *w, const uint8_t *cmds, uint8_t n) {
+    *w++ = SSD1306_CTRL_CMD;
+    for (uint8_t i = 0; i < n; i++) {
+        *w++ = cmds[i];
+    }
+    w[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    return w;
+}
+
+static uint16_t *appendData(uint16_t *w, const uint8_t *data, uint16_t n) {
+    *w++ = SSD1306_CTRL_DATA;
+    for (uint16_t i = 0; i < n; i++) {
+        *w++ = data[i];
+    }
+    w[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    return w;
+}
+
+// Columns [c0, c1] of one page, using the SSD1306 column/page window
+static uint16_t *appendRange(uint16_t *w, uint8_t page, uint8_t c0, uint8_t c1, const uint8_t *frame) {
+    const uint8_t window[] = {
+        SSD1306_COLUMNADDR, c0, c1,
+        SSD1306_PAGEADDR, page, page,
+    };
+    w = appendCommands(w, window, sizeof(window));
+    return appendData(w, frame + page * OLED_WIDTH + c0, c1 - c0 + 1);
+}
+
+// Copy the frame into wb and build the words for every column that differs
+// from prev. Returns the number of pixel bytes to send (0: nothing changed).
+static uint16_t fillWireBuffer(wire_buffer_t &wb, const uint8_t *buffer, const uint8_t *prev, bool all) {
+    uint16_t *w = wb.words;
+    uint16_t bytes = 0;
+
+    memcpy(wb.frame, buffer, OLED_BUFFER_SIZE);
+    wb.runs = 0;
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        const uint8_t *now = wb.frame + page * OLED_WIDTH;
+        const uint8_t *was = prev + page * OLED_WIDTH;
+        int16_t start = -1, last = -1;
+
+        for (uint8_t col = 0; col < OLED_WIDTH; col++) {
+            if (!all && now[col] == was[col]) {
+                continue;
+            }
+            if (start >= 0 && col - last > OLED_RANGE_GAP) {
+                w = appendRange(w, page, start, last, wb.frame);
+                wb.runEnd[wb.runs++] = w - wb.words;
+                bytes += last - start + 1;
+                start = -1;
+            }
+            if (start < 0) {
+                start = col;
+            }
+            last = col;
+        }
+        if (start >= 0) {
+            w = appendRange(w, page, start, last, wb.frame);
+            wb.runEnd[wb.runs++] = w - wb.words;
+            bytes += last - start + 1;
+        }
+    }
+    return bytes;
+}
+
+// End of a run (or abort), from the IRQ: hand the bus back at the sensor
+// clock, without TX DMA requests, for Wire. Then wake whoever waits in
+// oledFlush(), or core 1's loop to start the next run.
+static void releaseBus(bool idle) {
+    i2c_hw_t *hw = OLED_I2C->hw;
+    hw->intr_mask = 0;
+    hw->dma_cr = 0;
+    i2c_set_baudrate(OLED_I2C, I2C_SENSOR_CLOCK);
+    i2cBusUnlock();
+    if (idle && doneFn) {
+        doneFn();
+    }
+    __sev();
+}
+
+// STOP_DET fires at the end of every transaction in the stream; the run is
+// done once DMA has nothing left and the TX FIFO has drained.
+static void oledI2CIrq() {
+    i2c_hw_t *hw = OLED_I2C->hw;
+    uint32_t saved = spin_lock_blocking(stateLock);
+
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        dma_channel_abort(dmaChannel);
+        (void)hw->clr_tx_abrt;
+        (void)hw->clr_stop_det;
+        aborts = aborts + 1;
+        onWire = -1;
+        pending = -1;
+        sending = false;
+        fullRefresh = true; // no idea how much of the frame made it
+        spin_unlock(stateLock, saved);
+        releaseBus(true);
+        return;
+    }
+
+    (void)hw->clr_stop_det;
+    if (dma_channel_is_busy(dmaChannel) || !(hw->status & I2C_IC_STATUS_TFE_BITS)
+        || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS)) {
+        spin_unlock(stateLock, saved);
+        return;
+    }
+
+    run = run + 1;
+    if (run == wireBuffers[onWire].runs) {
+        framesSent = framesSent + 1;
+        profileRecordMicros(PROFILE_FLUSH, halMicros() - wireStart);
+        // Carry on with the waiting frame, if any
+        run = 0;
+        onWire = pending;
+        if (pending >= 0) {
+            shown = pending;
+            wireStart = halMicros();
+        }
+        pending = -1;
+    }
+    sending = false;
+    bool idle = onWire < 0;
+    spin_unlock(stateLock, saved);
+    releaseBus(idle);
+}
+
+void oledBegin() {
+    stateLock = spin_lock_instance(spin_lock_claim_unused(true));
+
+    dmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(OLED_I2C, true));
+    dma_channel_configure(dmaChannel, &c, &OLED_I2C->hw->data_cmd, nullptr, 0, false);
+
+    irq_set_exclusive_handler(I2C0_IRQ, oledI2CIrq);
+    irq_set_enabled(I2C0_IRQ, true);
+}
+
+void oledFlushAsync(const uint8_t *buffer) {
+    // The wire buffer not holding the panel's (upcoming) contents is ours to
+    // fill. Withdraw it from the completion interrupt first, so it can't
+    // chain a half written frame. A withdrawn frame never reached the panel,
+    // so the diff below is still against the right reference.
+    uint32_t saved = spin_lock_blocking(stateLock);
+    int8_t back = 1 - shown;
+    if (pending >= 0) {
+        replaced++;
+        pending = -1;
+    }
+    bool all = fullRefresh;
+    fullRefresh = false;
+    spin_unlock(stateLock, saved);
+
+    uint16_t bytes = fillWireBuffer(wireBuffers[back], buffer, wireBuffers[shown].frame, all);
+    if (bytes == 0) {
+        skipped++;
+        return;
+    }
+    bytesSent += bytes;
+
+    saved = spin_lock_blocking(stateLock);
+    if (onWire >= 0) {
+        pending = back;
+        spin_unlock(stateLock, saved);
+        return;
+    }
+    onWire = back;
+    shown = back;
+    run = 0;
+    wireStart = halMicros();
+    spin_unlock(stateLock, saved);
+    oledPoll();
+}
+
+void oledPoll() {
+    uint32_t saved = spin_lock_blocking(stateLock);
+    bool start = onWire >= 0 && !sending;
+    if (start) {
+        sending = true; // the IRQ only touches onWire/run while this is set
+    }
+    spin_unlock(stateLock, saved);
+    if (!start) {
+        return;
+    }
+
+    i2cBusLock(); // released by the interrupt at the end of the run
+    i2c_hw_t *hw = OLED_I2C->hw;
+    hw->enable = 0;
+    hw->tar = OLED_ADDRESS;
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+    hw->enable = 1;
+    i2c_set_baudrate(OLED_I2C, I2C_DISPLAY_CLOCK);
+    (void)hw->clr_intr;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    const wire_buffer_t &wb = wireBuffers[onWire];
+    uint16_t from = run ? wb.runEnd[run - 1] : 0;
+    dma_channel_transfer_from_buffer_now(dmaChannel, wb.words + from, wb.runEnd[run] - from);
+}
+
+void oledFlush(const uint8_t *buffer) {
+    oledFlushAsync(buffer);
+    while (oledBusy()) {
+        oledPoll();
+        __wfe();
+    }
+}
+
+// Off: display first, then the charge pump; on: the reverse
+void oledSetPower(bool on) {
+    while (oledBusy()) {
+        oledPoll();
+        __wfe();
+    }
+    const uint8_t off[] = {SSD1306_CTRL_CMD, SSD1306_DISPLAYOFF, SSD1306_CHARGEPUMP, 0x10};
+    const uint8_t wake[] = {SSD1306_CTRL_CMD, SSD1306_CHARGEPUMP, 0x14, SSD1306_DISPLAYON};
+    I2CBusGuard bus;
+    i2cWrite(OLED_ADDRESS, on ? wake : off, sizeof(off));
+}
+
+bool oledBusy() {
+    return onWire >= 0 || pending >= 0;
+}
+
+void oledOnFlushDone(oled_done_fn_t fn) {
+    doneFn = fn;
+}
+
+oled_stats_t oledStats() {
+    oled_stats_t stats;
+    stats.frames = framesSent;
+    stats.replaced = replaced;
+    stats.skipped = skipped;
+    stats.bytes = bytesSent;
+    stats.aborts = aborts;
+    return stats;
+}
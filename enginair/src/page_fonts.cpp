@@ -0,0 +1,23 @@
+// enginair page_fonts.cpp
+// Compile-time conversion of the ArialMT fonts, see page_fonts.h. Only the
+// characters the screens print are kept: values are formatted by fmt.h
+// (digits, '.', '-' for negatives and NO_VALUE), plus the units. The small
+// font takes the place of the GFX built-in one, which is drawn from the top.
+// The label and digit fonts are the same ArialMT_Plain_10, split in two
+// because a page font covers at most 32 consecutive characters: the
+// capitals of the screen labels, and the small numbers (with ':' for times).
+
+#include "page_fonts.h"
+#include "OLEDDisplayFonts.h"
+#include "screen_page.h"
+
+// The value and small fonts carry exactly what the atlas renders
+#define VALUE_CHARSET SCREEN_VALUE_CHARSET
+#define SMALL_CHARSET SCREEN_SMALL_CHARSET
+#define LABEL_CHARSET "ABCDEGHILOPQRU"
+#define DIGIT_CHARSET "0123456789.-:"
+
+OLED_PAGE_FONT(arialValueFont, ArialMT_Plain_16, VALUE_CHARSET, OLED_FONT_BASELINE);
+OLED_PAGE_FONT(arialSmallFont, ArialMT_Plain_10, SMALL_CHARSET, OLED_FONT_BASELINE);
+OLED_PAGE_FONT(arialLabelFont, ArialMT_Plain_10, LABEL_CHARSET, OLED_FONT_TOP);
+OLED_PAGE_FONT(arialDigitFont, ArialMT_Plain_10, DIGIT_CHARSET, OLED_FONT_TOP);
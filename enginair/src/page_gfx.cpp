@@ -0,0 +1,170 @@
+// enginair page_gfx.cpp
+// Page-layout blitter, see page_gfx.h
+
+#include <string.h>
+#include "page_gfx.h"
+
+void pageTranspose(const uint8_t *bits, uint32_t bitOffset, uint16_t rowBits, uint8_t width,
+                   uint8_t height, uint8_t *out) {
+    uint8_t pages = (height + 7) / 8;
+    memset(out, 0, pageSpriteSize(width, height));
+    for (uint8_t row = 0; row < height; row++) {
+        uint32_t bit = bitOffset + (uint32_t)row * rowBits;
+        for (uint8_t col = 0; col < width; col++, bit++) {
+            if (bits[bit >> 3] & (0x80 >> (bit & 7))) {
+                out[col * pages + row / 8] |= 1 << (row & 7);
+            }
+        }
+    }
+}
+
+// Each source byte lands across two pages: shifted down by the top edge's
+// offset within its page, the low part in one and the spill in the next.
+void pageBlit(uint8_t *frame, int16_t x, int16_t y, const page_sprite_t &sprite) {
+    int16_t left = x + sprite.xOffset;
+    int16_t top = y + sprite.yOffset;
+    uint8_t pages = (sprite.height + 7) / 8;
+    int16_t firstPage = top >> 3; // floor, also for negative top
+    uint8_t shift = top & 7;
+
+    int16_t from = left < 0 ? -left : 0;
+    int16_t to = left + sprite.width > OLED_WIDTH ? OLED_WIDTH - left : sprite.width;
+    for (uint8_t p = 0; p < pages; p++) {
+        int16_t page = firstPage + p;
+        bool low = page >= 0 && page < OLED_PAGES;
+        bool high = page + 1 >= 0 && page + 1 < OLED_PAGES && shift;
+        if (!low && !high) {
+            continue;
+        }
+        const uint8_t *src = sprite.columns + p;
+        int16_t dst = page * OLED_WIDTH + left; // may be one page above the frame
+        for (int16_t c = from; c < to; c++) {
+            uint16_t bits = src[c * pages] << shift;
+            if (low) {
+                frame[dst + c] |= bits;
+            }
+            if (high) {
+                frame[dst + c + OLED_WIDTH] |= bits >> 8;
+            }
+        }
+    }
+}
+
+void pageText(uint8_t *frame, const page_font_t &font, page_cursor_t &cursor, const char *text) {
+    for (; *text; text++) {
+        uint8_t c = *text;
+        if (c < font.first || c > font.last) {
+            continue;
+        }
+        const page_sprite_t &glyph = font.glyphs[c - font.first];
+        if (glyph.width && glyph.height) {
+            if (cursor.x + glyph.xOffset + glyph.width > OLED_WIDTH) {
+                cursor.x = 0;
+                cursor.y += font.yAdvance;
+            }
+            pageBlit(frame, cursor.x, cursor.y, glyph);
+        }
+        cursor.x += glyph.xAdvance;
+    }
+}
+
+int16_t pageTextWidth(const page_font_t &font, const char *text) {
+    int16_t width = 0;
+    for (; *text; text++) {
+        uint8_t c = *text;
+        if (c >= font.first && c <= font.last) {
+            width += font.glyphs[c - font.first].xAdvance;
+        }
+    }
+    return width;
+}
+
+void pageCache(const page_sprite_t &sprite, int16_t y, uint8_t *out, page_cached_t &cached) {
+    int16_t top = y + sprite.yOffset;
+    uint8_t shift = top & 7;
+    uint8_t srcPages = (sprite.height + 7) / 8;
+    uint8_t pages = (shift + sprite.height + 7) / 8;
+    memset(out, 0, sprite.width * pages);
+    for (uint8_t c = 0; c < sprite.width; c++) {
+        for (uint8_t p = 0; p < srcPages; p++) {
+            uint16_t bits = sprite.columns[c * srcPages + p] << shift;
+            out[p * sprite.width + c] |= bits;
+            if (p + 1 < pages) {
+                out[(p + 1) * sprite.width + c] |= bits >> 8;
+            }
+        }
+    }
+    cached = {0, sprite.width, pages, (int8_t)(top >> 3), sprite.xOffset};
+}
+
+void pageBlitCached(uint8_t *frame, int16_t x, const uint8_t *data, const page_cached_t &cached) {
+    int16_t left = x + cached.xOffset;
+    int16_t from = left < 0 ? -left : 0;
+    int16_t to = left + cached.width > OLED_WIDTH ? OLED_WIDTH - left : cached.width;
+    const uint8_t *src = data + cached.offset;
+    for (uint8_t p = 0; p < cached.pages; p++, src += cached.width) {
+        int16_t page = cached.topPage + p;
+        if (page < 0 || page >= OLED_PAGES) {
+            continue;
+        }
+        uint8_t *dst = frame + page * OLED_WIDTH + left;
+        for (int16_t c = from; c < to; c++) {
+            dst[c] |= src[c];
+        }
+    }
+}
+
+bool pageAtlasBuild(page_atlas_t &atlas, const page_font_t &font, int16_t y, const char *charset,
+                    uint8_t *&pool, const uint8_t *poolEnd) {
+    memset(&atlas, 0, sizeof(atlas));
+    atlas.font = &font;
+    atlas.y = y;
+    atlas.data = pool;
+    uint16_t used = 0;
+    bool all = true;
+    for (; *charset; charset++) {
+        uint8_t c = *charset;
+        if (c < font.first || c > font.last) {
+            continue;
+        }
+        const page_sprite_t &glyph = font.glyphs[c - font.first];
+        page_cached_t &cached = atlas.glyphs[c - font.first];
+        if (cached.width || !glyph.width || !glyph.height) {
+            continue; // repeated or blank
+        }
+        uint16_t bytes = pageCachedSize(glyph, y);
+        if (pool + used + bytes > poolEnd) {
+            all = false;
+            continue;
+        }
+        pageCache(glyph, y, pool + used, cached);
+        cached.offset = used;
+        used += bytes;
+    }
+    pool += used;
+    return all;
+}
+
+void pageAtlasText(uint8_t *frame, const page_atlas_t &atlas, page_cursor_t &cursor, const char *text) {
+    const page_font_t &font = *atlas.font;
+    for (; *text; text++) {
+        uint8_t c = *text;
+        if (c < font.first || c > font.last) {
+            continue;
+        }
+        const page_sprite_t &glyph = font.glyphs[c - font.first];
+        if (glyph.width && glyph.height) {
+            if (cursor.x + glyph.xOffset + glyph.width > OLED_WIDTH) {
+                cursor.x = 0;
+                cursor.y += font.yAdvance;
+            }
+            const page_cached_t &cached = atlas.glyphs[c - font.first];
+            if (cursor.y == atlas.y && cached.width) {
+                pageBlitCached(frame, cursor.x, atlas.data, cached);
+            } else {
+                pageBlit(frame, cursor.x, cursor.y, glyph);
+            }
+        }
+        cursor.x += glyph.xAdvance;
+    }
+}
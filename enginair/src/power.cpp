@@ -0,0 +1,87 @@
+// enginair power.cpp
+// Power mode helpers and duty cycle accounting, see power.h
+
+#include "hal.h"
+#include "power.h"
+
+struct power_component_info_t {
+    const char *name;
+    uint32_t activeUa; // typical, from the datasheets; the estimate is no better than these
+    uint32_t idleUa;
+};
+
+static const power_component_info_t componentInfo[POWER_COMPONENTS] = {
+    {"core0", 10000, 4000}, // RP2040 at 133 MHz, split per core; WFE keeps the clocks running
+    {"core1", 10000, 4000},
+    {"sen50", 70000, 2600}, // measurement vs idle mode
+    {"scd40", 15000, 3200}, // averages at 3.3 V: periodic vs low power periodic
+    {"oled", 10000, 10},    // a screen of digits lit vs sleep mode
+};
+
+struct power_tally_t {
+    uint64_t active; // us, up to since
+    uint64_t since;  // when the current active stretch began
+    bool on;
+};
+
+static power_tally_t tallies[POWER_COMPONENTS];
+
+uint32_t powerSamplePeriodUs(const power_config_t &config) {
+    return config.mode == POWER_LOW ? config.period * 1000000u : 1000000u;
+}
+
+bool powerPmDutyCycled(const power_config_t &config) {
+    return config.mode == POWER_LOW && config.period >= config.warmup + POWER_IDLE_MIN_S;
+}
+
+void powerSetActive(power_component_t component, bool active) {
+    power_tally_t &t = tallies[component];
+    if (active == t.on) {
+        return;
+    }
+    uint64_t now = halMicros64();
+    if (t.on) {
+        t.active += now - t.since;
+    }
+    t.since = now;
+    t.on = active;
+}
+
+void powerAddActive(power_component_t component, uint32_t us) {
+    tallies[component].active += us;
+}
+
+power_usage_t powerUsage() {
+    power_usage_t usage;
+    usage.time = halMicros64();
+    for (uint8_t c = 0; c < POWER_COMPONENTS; c++) {
+        const power_tally_t &t = tallies[c];
+        usage.active[c] = t.active + (t.on ? usage.time - t.since : 0);
+    }
+    return usage;
+}
+
+const char *powerComponentName(power_component_t component) {
+    return componentInfo[component].name;
+}
+
+uint16_t powerDuty(const power_usage_t &from, const power_usage_t &to, power_component_t component) {
+    uint64_t span = to.time - from.time;
+    uint64_t active = to.active[component] - from.active[component];
+    if (span == 0) {
+        return 0;
+    }
+    return active >= span ? 1000 : (uint16_t)((active * 1000 + span / 2) / span);
+}
+
+uint32_t powerAverageUa(const power_usage_t &from, const power_usage_t &to, power_component_t component) {
+    const power_component_info_t &info = componentInfo[component];
+    uint64_t span = to.time - from.time;
+    uint64_t active = to.active[component] - from.active[component];
+    if (span == 0) {
+        return info.idleUa;
+    }
+    active = active > span ? span : active;
+    // Exact rather than from the rounded duty: the cores are awake well under 0.1%
+    return info.idleUa + (info.activeUa - info.idleUa) * active / span;
+}
@@ -0,0 +1,132 @@
+// enginair profile.cpp
+// Stage latency histograms, see profile.h
+
+#include <string.h>
+#include "profile.h"
+
+#define PROFILE_SUB_MASK ((1u << PROFILE_SUB_BITS) - 1)
+
+struct profile_histogram_t {
+    uint32_t generation; // profileReset() count this was last cleared for
+    uint32_t count;
+    uint32_t overruns;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[PROFILE_BUCKETS];
+};
+
+struct profile_stage_info_t {
+    const char *name;
+    uint32_t budgetUs; // what a 1 Hz loop can afford; above this is an overrun
+};
+
+static const profile_stage_info_t stageInfo[PROFILE_STAGES] = {
+    {"sen50", 5000},  // 24 byte read at 100 kHz is ~2.7 ms
+    {"scd40", 2000},
+    {"store", 1000},  // a flash sector write (~50 ms) always overruns
+    {"draw", 5000},
+    {"flush", 15000}, // full frame at 400 kHz is ~12 ms
+    {"output", 2000},
+    {"alarm", 100},   // interrupt latency
+    {"start", 5000},  // behind the SCD40 or a flash write at worst
+};
+
+static profile_histogram_t histograms[PROFILE_STAGES];
+static volatile uint32_t generation = 0;
+
+static inline uint8_t bucketOf(uint32_t cycles) {
+    if (cycles <= PROFILE_SUB_MASK) {
+        return cycles;
+    }
+    uint8_t msb = 31 - __builtin_clz(cycles);
+    return ((msb - PROFILE_SUB_BITS + 1) << PROFILE_SUB_BITS)
+           + ((cycles >> (msb - PROFILE_SUB_BITS)) & PROFILE_SUB_MASK);
+}
+
+void profileRecord(profile_stage_t stage, uint32_t cycles) {
+    profile_histogram_t &h = histograms[stage];
+    if (h.generation != generation) {
+        memset(&h, 0, sizeof(h));
+        h.generation = generation;
+    }
+    if (h.count == 0 || cycles < h.min) {
+        h.min = cycles;
+    }
+    if (cycles > h.max) {
+        h.max = cycles;
+    }
+    if (cycles > stageInfo[stage].budgetUs * halCyclesPerMicro()) {
+        h.overruns++;
+    }
+    h.buckets[bucketOf(cycles)]++;
+    h.count++;
+    h.total += cycles;
+}
+
+void profileRecordMicros(profile_stage_t stage, uint32_t us) {
+    profileRecord(stage, us * halCyclesPerMicro());
+}
+
+const char *profileStageName(profile_stage_t stage) {
+    return stageInfo[stage].name;
+}
+
+uint32_t profileBudgetUs(profile_stage_t stage) {
+    return stageInfo[stage].budgetUs;
+}
+
+static inline bool isCurrent(const profile_histogram_t &h) {
+    return h.generation == generation && h.count > 0;
+}
+
+uint32_t profileBucketLow(uint8_t bucket) {
+    if (bucket <= PROFILE_SUB_MASK) {
+        return bucket;
+    }
+    if (bucket >= PROFILE_BUCKETS) {
+        return UINT32_MAX;
+    }
+    uint8_t octave = bucket >> PROFILE_SUB_BITS;
+    uint32_t mantissa = (1u << PROFILE_SUB_BITS) | (bucket & PROFILE_SUB_MASK);
+    return mantissa << (octave - 1);
+}
+
+uint32_t profileBucketCount(profile_stage_t stage, uint8_t bucket) {
+    const profile_histogram_t &h = histograms[stage];
+    return isCurrent(h) && bucket < PROFILE_BUCKETS ? h.buckets[bucket] : 0;
+}
+
+// Upper edge of the bucket holding the given rank, clamped to the observed
+// range so small samples don't report more than the true maximum
+static uint32_t percentile(const profile_histogram_t &h, uint32_t count, uint8_t percent) {
+    uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = profileBucketLow(i + 1) - 1;
+            return upper < h.min ? h.min : upper > h.max ? h.max : upper;
+        }
+    }
+    return h.max;
+}
+
+bool profileSummary(profile_stage_t stage, profile_summary_t &out) {
+    const profile_histogram_t &h = histograms[stage];
+    if (!isCurrent(h)) {
+        return false;
+    }
+    out.count = h.count;
+    out.overruns = h.overruns;
+    out.min = h.min;
+    out.max = h.max;
+    out.total = h.total;
+    out.p50 = percentile(h, out.count, 50);
+    out.p99 = percentile(h, out.count, 99);
+    return true;
+}
+
+void profileReset() {
+    generation = generation + 1;
+}
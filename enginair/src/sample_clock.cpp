@@ -0,0 +1,52 @@
+// enginair sample_clock.cpp
+// Alarm-driven sample ticks, see sample_clock.h
+
+#include "hal.h"
+#include "sample_clock.h"
+#include "profile.h"
+
+// Written by the interrupt only. The count doubles as a sequence number:
+// the loop reads it before and after the tick fields and retries if the
+// interrupt came in between.
+static volatile uint32_t ticks = 0;
+static volatile uint32_t tickDue;
+static volatile uint32_t tickTime;
+
+static uint32_t taken = 0; // ticks seen by sampleClockTake()
+static uint32_t missed = 0;
+static uint32_t period = 0;
+
+static void onAlarm(uint32_t now, uint32_t due) {
+    tickDue = due;
+    tickTime = now;
+    ticks = ticks + 1;
+}
+
+void sampleClockStart(uint32_t first, uint32_t periodUs) {
+    period = periodUs;
+    halAlarmStart(first, periodUs, onAlarm);
+}
+
+bool sampleClockTake(sample_tick_t &tick) {
+    uint32_t count;
+    do {
+        count = ticks;
+        tick.due = tickDue;
+        tick.time = tickTime;
+    } while (count != ticks);
+    if (count == taken) {
+        return false;
+    }
+    missed += count - taken - 1;
+    taken = count;
+    profileRecordMicros(PROFILE_ALARM, tick.time - tick.due);
+    return true;
+}
+
+sample_clock_stats_t sampleClockStats() {
+    sample_clock_stats_t stats;
+    stats.period = period;
+    stats.ticks = ticks;
+    stats.missed = missed;
+    return stats;
+}
@@ -0,0 +1,134 @@
+// enginair scd40.cpp
+// Non-blocking SCD40 driver, see scd40.h
+
+#include "hal.h"
+#include "scd40.h"
+
+// Commands and execution times from the SCD4x datasheet
+#define SCD4X_CMD_START_PERIODIC 0x21B1
+#define SCD4X_CMD_START_LOW_POWER_PERIODIC 0x21AC
+#define SCD4X_CMD_STOP_PERIODIC 0x3F86
+#define SCD4X_CMD_DATA_READY 0xE4B8
+#define SCD4X_CMD_READ_MEASUREMENT 0xEC05
+#define SCD4X_STOP_US 500000
+#define SCD4X_START_US 1000 // no execution time given, keep a margin
+#define SCD4X_DATA_READY_US 1000
+#define SCD4X_READ_US 1000
+#define SCD4X_DATA_READY_MASK 0x07FF // any of these bits set: data ready
+
+driver_event_t Scd40::fail(uint16_t err, const char *context, state_t next) {
+    error = err;
+    errorContext = context;
+    state = next;
+    return DRIVER_ERROR;
+}
+
+void Scd40::begin(bool lowPower) {
+    // A measurement might be running from a previous startup
+    low = lowPower;
+    readRequested = false;
+    pendingError = sensirionIssue(dev, SCD4X_CMD_STOP_PERIODIC, SCD4X_STOP_US);
+    if (pendingError) {
+        dev.readyAt = halMicros(); // report it, then try to start anyway
+    }
+    state = STOPPING;
+}
+
+void Scd40::requestRead(bool direct) {
+    readRequested = true;
+    readDirect = direct;
+}
+
+driver_event_t Scd40::poll(uint32_t now) {
+    uint16_t words[3];
+    uint16_t err;
+
+    if (pendingError) {
+        err = pendingError;
+        pendingError = 0;
+        return fail(err, "Error stopping SCD40 measurement: ", state);
+    }
+
+    switch (state) {
+        case OFF:
+            return DRIVER_NONE;
+
+        case STOPPING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            sensirionFetch(dev, words);
+            err = sensirionIssue(dev, low ? SCD4X_CMD_START_LOW_POWER_PERIODIC : SCD4X_CMD_START_PERIODIC,
+                                 SCD4X_START_US);
+            if (err) {
+                return fail(err, "Error starting SCD40 measurement: ", OFF);
+            }
+            state = STARTING;
+            return DRIVER_NONE;
+
+        case STARTING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            sensirionFetch(dev, words);
+            state = MEASURING;
+            return DRIVER_STARTED;
+
+        case MEASURING:
+            if (!readRequested) {
+                return DRIVER_NONE;
+            }
+            readRequested = false;
+            if (readDirect) {
+                err = sensirionIssue(dev, SCD4X_CMD_READ_MEASUREMENT, SCD4X_READ_US, 3);
+                if (err) {
+                    return fail(err, "Error reading measurement from SCD40: ", MEASURING);
+                }
+                state = READING;
+                return DRIVER_NONE;
+            }
+            err = sensirionIssue(dev, SCD4X_CMD_DATA_READY, SCD4X_DATA_READY_US, 1);
+            if (err) {
+                return fail(err, "Couldn't get SCD40 data ready flag: ", MEASURING);
+            }
+            state = CHECKING;
+            return DRIVER_NONE;
+
+        case CHECKING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            err = sensirionFetch(dev, words);
+            if (err) {
+                return fail(err, "Couldn't get SCD40 data ready flag: ", MEASURING);
+            }
+            if (!(words[0] & SCD4X_DATA_READY_MASK)) {
+                state = MEASURING;
+                return DRIVER_NOT_READY;
+            }
+            err = sensirionIssue(dev, SCD4X_CMD_READ_MEASUREMENT, SCD4X_READ_US, 3);
+            if (err) {
+                return fail(err, "Error reading measurement from SCD40: ", MEASURING);
+            }
+            state = READING;
+            return DRIVER_NONE;
+
+        case READING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            state = MEASURING;
+            err = sensirionFetch(dev, words);
+            if (err == SENSIRION_ERR_READ && readDirect) {
+                return DRIVER_NOT_READY; // NACK: nothing new in the buffer
+            }
+            if (err) {
+                return fail(err, "Error reading measurement from SCD40: ", MEASURING);
+            }
+            co2 = words[0];
+            temp = words[1];
+            humi = words[2];
+            return DRIVER_SAMPLE;
+    }
+    return DRIVER_NONE;
+}
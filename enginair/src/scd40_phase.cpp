@@ -0,0 +1,115 @@
+// enginair scd40_phase.cpp
+// Predictive SCD40 read scheduling, see scd40_phase.h
+
+#include "scd40_phase.h"
+
+void Scd40Phase::begin(uint32_t now, uint32_t nominalUs) {
+    mode = POLLING;
+    nominal = nominalUs;
+    period = nominalUs;
+    haveAnchor = false;
+    startTime = now;
+    counts = {};
+}
+
+bool Scd40Phase::nextRequest() {
+    direct = (mode == LOCKED);
+    probeChecks++;
+    if (direct) {
+        counts.reads++;
+    } else {
+        counts.checks++;
+    }
+    return direct;
+}
+
+// Refine the period from the time since we first locked on, which averages
+// out the poll-interval uncertainty of each individual measurement
+void Scd40Phase::measurePeriod(uint32_t now) {
+    uint32_t measured = (now - anchor) / sinceAnchor;
+    uint32_t slack = nominal / SCD40_PERIOD_TOLERANCE;
+    if (measured > nominal - slack && measured < nominal + slack) {
+        period = measured;
+    } else {
+        // Lost track of how many samples went by (sensor restarted etc)
+        anchor = now;
+        sinceAnchor = 0;
+    }
+}
+
+uint32_t Scd40Phase::onSample(uint32_t now) {
+    counts.samples++;
+    if (!direct) {
+        counts.reads++; // the flag was set, so the driver read it as well
+    }
+    sinceAnchor++;
+
+    switch (mode) {
+        case POLLING:
+            // The completion happened within the last poll interval
+            if (haveAnchor) {
+                measurePeriod(now); // relocking after a miss
+            } else {
+                anchor = now;
+                sinceAnchor = 0;
+                haveAnchor = true;
+            }
+            predicted = now;
+            break;
+
+        case PROBING:
+            if (probeChecks == 1) {
+                // Already there on the first check: the sample came earlier
+                // than the whole probe window, so we can't tell when. Poll
+                // for the next one from scratch.
+                counts.misses++;
+                mode = POLLING;
+                return now + SCD40_POLL_US;
+            }
+            measurePeriod(now);
+            predicted = now;
+            break;
+
+        case LOCKED:
+            predicted += period;
+            break;
+    }
+
+    sinceProbe++;
+    if (mode != POLLING && sinceProbe >= SCD40_PROBE_EVERY) {
+        sinceProbe = 0;
+        counts.probes++;
+        probeChecks = 0;
+        mode = PROBING;
+        return predicted + period - SCD40_PROBE_LEAD_US;
+    }
+    if (mode == POLLING) {
+        sinceProbe = 0;
+    }
+    mode = LOCKED;
+    return predicted + period + SCD40_READ_MARGIN_US;
+}
+
+uint32_t Scd40Phase::onNotReady(uint32_t now) {
+    switch (mode) {
+        case LOCKED:
+            // The sample wasn't there when it should have been: we drifted
+            counts.misses++;
+            mode = POLLING;
+            return now + SCD40_POLL_US;
+        case PROBING:
+            return now + SCD40_PROBE_US;
+        case POLLING:
+        default:
+            return now + SCD40_POLL_US;
+    }
+}
+
+scd40_bus_stats_t Scd40Phase::stats(uint32_t now) const {
+    scd40_bus_stats_t s = counts;
+    s.baseline = (now - startTime) / 1000000 + s.samples;
+    uint32_t sent = s.checks + s.reads;
+    s.saved = s.baseline > sent ? s.baseline - sent : 0;
+    s.period = period;
+    return s;
+}
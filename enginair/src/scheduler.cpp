@@ -0,0 +1,126 @@
+// enginair scheduler.cpp
+// Deadline-driven cooperative scheduler, see scheduler.h
+
+#include "hal.h"
+#include "scheduler.h"
+
+static task_t *taskTable = nullptr;
+static uint8_t taskCount = 0;
+static uint32_t tickTime = 0;
+static task_t *running = nullptr;
+static bool deadlineSet = false; // running task moved its own deadline
+static uint32_t wakeTimes[SCHEDULER_MAX_WAKES];
+static uint8_t wakeCount = 0;
+
+// Wrap-safe "a is at or after b" for the 32-bit halMicros() counter
+static inline bool reached(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
+
+void schedulerStart(task_t *tasks, uint8_t count) {
+    taskTable = tasks;
+    taskCount = count;
+
+    uint32_t now = halMicros();
+    for (uint8_t i = 0; i < count; i++) {
+        tasks[i].deadline = now + tasks[i].offset_us;
+        tasks[i].overruns = 0;
+        tasks[i].stopped = false;
+    }
+}
+
+void schedulerRun() {
+    uint32_t now = halMicros();
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        task_t &task = taskTable[i];
+        if (task.stopped || !reached(now, task.deadline)) {
+            continue;
+        }
+
+        tickTime = task.deadline;
+        running = &task;
+        deadlineSet = false;
+        task.fn();
+        running = nullptr;
+        if (deadlineSet) {
+            continue;
+        }
+
+        // Advance by whole periods so the phase is kept. If we are more than
+        // a period late, skip the missed runs instead of bursting to catch up.
+        task.deadline += task.period_us;
+        now = halMicros();
+        if (reached(now, task.deadline)) {
+            uint32_t missed = (now - task.deadline) / task.period_us + 1;
+            task.deadline += missed * task.period_us;
+            task.overruns += missed;
+        }
+    }
+}
+
+void schedulerIdle() {
+    uint32_t now = halMicros();
+
+    // Sleep until the earliest deadline. Any other event (USB, IRQs) also
+    // wakes us, which is fine: loop() just calls back in here.
+    int32_t wait = INT32_MAX;
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (taskTable[i].stopped) {
+            continue;
+        }
+        int32_t remaining = (int32_t)(taskTable[i].deadline - now);
+        if (remaining < wait) {
+            wait = remaining;
+        }
+    }
+    for (uint8_t i = 0; i < wakeCount;) {
+        int32_t remaining = (int32_t)(wakeTimes[i] - now);
+        if (remaining <= 0) {
+            wakeTimes[i] = wakeTimes[--wakeCount]; // passed, drop it
+            continue;
+        }
+        if (remaining < wait) {
+            wait = remaining;
+        }
+        i++;
+    }
+    if (wait > 0) {
+        halSleepUntil(now + wait);
+    }
+}
+
+void schedulerWakeAt(uint32_t t) {
+    if (wakeCount < SCHEDULER_MAX_WAKES) {
+        wakeTimes[wakeCount++] = t;
+        return;
+    }
+    // Full: keep the earliest ones, the loop re-checks everything on wake anyway
+    uint8_t latest = 0;
+    for (uint8_t i = 1; i < wakeCount; i++) {
+        if ((int32_t)(wakeTimes[i] - wakeTimes[latest]) > 0) {
+            latest = i;
+        }
+    }
+    if ((int32_t)(t - wakeTimes[latest]) < 0) {
+        wakeTimes[latest] = t;
+    }
+}
+
+void schedulerSetDeadline(task_t &task, uint32_t t) {
+    task.deadline = t;
+    task.stopped = false;
+    if (&task == running) {
+        deadlineSet = true;
+    }
+}
+
+void schedulerStopCurrent() {
+    if (running) {
+        running->stopped = true;
+    }
+}
+
+uint32_t schedulerTickTime() {
+    return tickTime;
+}
@@ -0,0 +1,327 @@
+// enginair screen.cpp
+// OLED screens, see screen.h. The value, detail, stats, AQI and trend
+// screens are drawn by the page blitter (screen_page.h) in the ArialMT
+// fonts; boot messages still go through GFX.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include "screen.h"
+#include "symbols.h"
+#include "hal.h"
+#include "i2c_bus.h"
+#include "oled.h"
+#include "fmt.h"
+#include "sample.h"
+#include "page_gfx.h"
+#include "screen_page.h"
+#include "page_fonts.h"
+#include "bench.h"
+
+#define DISPLAY_WIDTH OLED_WIDTH
+#define DISPLAY_HEIGHT OLED_HEIGHT
+#define DISPLAY_ADDRESS OLED_ADDRESS
+Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1); // -1: no reset pin
+#include <Fonts/FreeSans9pt7b.h> // drawValuesGfx() only
+// Meshtastic FONT_MEDIUM = ArialMT_Plain_16, FONT_SMALL = ArialMT_Plain_10,
+// converted at compile time in page_fonts.cpp
+
+// Same rule as main.cpp: nothing on the render path may use the heap
+#pragma GCC poison String
+
+// The GFX fonts as page fonts, transposed into RAM by screenBench() so the
+// page renderer can be checked against drawValuesGfx()
+#define VALUE_FONT_FIRST '%'
+#define VALUE_FONT_LAST '9'
+#define VALUE_FONT_DATA 1024
+#define SMALL_FONT_FIRST 'm'
+#define SMALL_FONT_LAST 'p'
+#define SMALL_GLYPH_WIDTH 6 // 5 columns and the gap, as GFX draws them
+#define SMALL_GLYPH_HEIGHT 8
+#define SMALL_GLYPH_BASELINE 7 // row under the lower case letters
+static uint8_t valueFontData[VALUE_FONT_DATA];
+static uint8_t smallFontData[(SMALL_FONT_LAST - SMALL_FONT_FIRST + 1) * SMALL_GLYPH_WIDTH];
+static page_font_t gfxValueFont;
+static page_font_t gfxSmallFont;
+
+static bool pageFontFromGfx(page_font_t &font, const GFXfont *gfx, uint8_t first, uint8_t last,
+                            uint8_t *pool, uint16_t size) {
+    font.first = first;
+    font.last = last;
+    font.yAdvance = gfx->yAdvance;
+    uint16_t used = 0;
+    for (uint8_t c = first; c <= last; c++) {
+        const GFXglyph &g = gfx->glyph[c - gfx->first];
+        page_sprite_t &sprite = font.glyphs[c - first];
+        uint16_t bytes = pageSpriteSize(g.width, g.height);
+        if (used + bytes > size) {
+            return false;
+        }
+        pageTranspose(gfx->bitmap, g.bitmapOffset * 8, g.width, g.width, g.height, pool + used);
+        sprite = {pool + used, g.width, g.height, g.xOffset, g.yOffset, g.xAdvance};
+        used += bytes;
+    }
+    return true;
+}
+
+// The built-in font isn't exposed by GFX, but it is stored in columns
+// already: draw each glyph into the corner of the (page format) buffer and
+// take the bytes from there. Clobbers the buffer.
+static void pageFontFromBuiltin(page_font_t &font, uint8_t first, uint8_t last, uint8_t *pool) {
+    font.first = first;
+    font.last = last;
+    font.yAdvance = SMALL_GLYPH_HEIGHT;
+    display.setFont();
+    for (uint8_t c = first; c <= last; c++) {
+        uint8_t *columns = pool + (c - first) * SMALL_GLYPH_WIDTH;
+        display.clearDisplay();
+        display.drawChar(0, 0, c, SSD1306_WHITE, SSD1306_WHITE, 1); // transparent
+        memcpy(columns, display.getBuffer(), SMALL_GLYPH_WIDTH);
+        font.glyphs[c - first] = {columns, SMALL_GLYPH_WIDTH, SMALL_GLYPH_HEIGHT, 0, -SMALL_GLYPH_BASELINE,
+                                  SMALL_GLYPH_WIDTH};
+    }
+    display.clearDisplay();
+}
+
+// Whether the frame still holds the trend screen as showTrend() left it
+static bool trendShown = false;
+
+// Initialise the SSD1306 OLED display settings and display a small message
+bool initDisplay() {
+    bool ok;
+    {
+        I2CBusGuard bus;
+        ok = display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS, true, false); // Wire already begun
+    }
+    if(!ok) {
+        halSerialPrintln("Couldn't initialise SSD1306");
+        return false;
+    }
+    oledBegin(); // DMA flush from here on
+
+    screenPageBegin();
+
+    display.setTextSize(1);
+    // TODO: Uncomment when font fixed
+    //display.setFont(&FreeSans9pt7b);
+    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK); // foreground, background
+    display.setCursor(0, 20);
+    display.println("display init...");
+    oledFlush(display.getBuffer());
+
+    return true;
+}
+
+// Display a short message on the OLED display (and Serial) with a "log level"
+void showMessage(const char *message, message_t level) {
+    trendShown = false;
+    display.clearDisplay();
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(0,0);
+
+    // The serial copy is built whole, so it goes out as one line
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = line;
+    *p = '\0';
+    
+    switch (level) {
+        case DEBUG:
+            display.println("DEBUG: ");
+            p = fmtStr(p, end, "DEBUG: ");
+            break;
+        case INFO:
+            display.println("INFO: ");
+            p = fmtStr(p, end, "INFO: ");
+            break;
+        case WARN:
+            display.println("WARN: ");
+            p = fmtStr(p, end, "WARN: ");
+            break;
+        case ERR:
+            display.println("ERROR: ");
+            p = fmtStr(p, end, "ERROR: ");
+            break;
+        case NAME:
+            display.print(PROJECT_NAME);
+            display.println(": ");
+            p = fmtStr(p, end, PROJECT_NAME ": ");
+            break;
+        default:
+            display.println("(no msg type): ");
+    }
+
+    display.println(message);
+    oledFlush(display.getBuffer());
+
+    // print to serial, for good measure
+    fmtStr(p, end, message);
+    halSerialPrintln(line);
+}
+
+void showValues_LargeText(uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    trendShown = false;
+    screenDrawValues(display.getBuffer(), pm2p5, co2, temp, humi, flags);
+    oledFlushAsync(display.getBuffer());
+}
+
+void showTrend(trend_mode_t mode) {
+    screenDrawTrend(display.getBuffer(), mode, trendShown);
+    trendShown = true;
+    oledFlushAsync(display.getBuffer());
+}
+
+// The GFX version of screenDrawValues(), kept as the reference it has to
+// match pixel for pixel (see screenBench)
+#define BOTLINE_Y 29
+#define TOPLINE_Y 14
+#define RIGHTHALF_X 64
+#define UNIT_Y (TOPLINE_Y - 1) // baseline of "ppm"
+static void drawValuesGfx(uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    int x, y; // temp vars
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    bool pm = flags & SAMPLE_PM_VALID;
+    bool co2Valid = flags & SAMPLE_CO2_VALID;
+
+    display.clearDisplay();
+    display.setFont(&FreeSans9pt7b);
+    display.setTextSize(1);
+    display.setCursor(0,TOPLINE_Y);
+    pm ? fmtFixed1(text, end, pm2p5) : fmtStr(text, end, NO_VALUE);
+    display.print(text);
+
+    display.setFont(); // reset to default font
+    x = display.getCursorX();
+    display.drawBitmap(x+2, 0, icon_ugm3, 16, 16, SSD1306_WHITE);
+
+    display.setFont(&FreeSans9pt7b);
+    display.setCursor(RIGHTHALF_X, TOPLINE_Y);
+    co2Valid ? fmtUint(text, end, co2) : fmtStr(text, end, NO_VALUE);
+    display.print(text);
+    display.setFont(); // the built-in font is drawn from its top left corner
+    display.setCursor(display.getCursorX()+1, UNIT_Y - SMALL_GLYPH_BASELINE);
+    display.print("ppm");
+
+    display.setFont(&FreeSans9pt7b);
+    display.setCursor(0, BOTLINE_Y);
+    co2Valid ? fmtFixed1(text, end, temp) : fmtStr(text, end, NO_VALUE);
+    display.print(text);
+    x = display.getCursorX();
+    y = display.getCursorY();
+    display.drawBitmap(x+1, y-10, icon_degC, 8, 7, SSD1306_WHITE);
+    display.setCursor(RIGHTHALF_X, BOTLINE_Y);
+    co2Valid ? fmtFixed1(text, end, humi) : fmtStr(text, end, NO_VALUE);
+    display.print(text);
+    display.print("%");
+}
+
+void showPMValues(uint16_t pm1p0, uint16_t pm2p5, uint16_t pm4p0, uint16_t pm10p0, uint8_t flags) {
+    (void)pm1p0; // PM2.5 and PM10 only, for brevity
+    (void)pm4p0;
+    trendShown = false;
+    screenDrawPM(display.getBuffer(), pm2p5, pm10p0, flags);
+    oledFlushAsync(display.getBuffer());
+}
+
+void showCO2Values(uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    trendShown = false;
+    screenDrawClimate(display.getBuffer(), co2, temp, humi, flags);
+    oledFlushAsync(display.getBuffer());
+}
+
+void showStats(const screen_stats_t &stats) {
+    trendShown = false;
+    screenDrawStats(display.getBuffer(), stats);
+    oledFlushAsync(display.getBuffer());
+}
+
+void showAQIValues(const aqi_t &aqi) {
+    trendShown = false;
+    screenDrawAQI(display.getBuffer(), aqi);
+    oledFlushAsync(display.getBuffer());
+}
+
+// Bench: cycles per frame of both renderers over a spread of values (including
+// missing ones and wide CO2 readings that make GFX wrap), and whether every
+// frame came out identical with the page renderer on the GFX fonts; then the
+// page renderer on the ArialMT fonts it normally uses, and a detail screen
+#define SCREEN_BENCH_FRAMES 64
+
+static uint8_t benchFrame[OLED_BUFFER_SIZE];
+
+static void benchValues(uint32_t i, uint16_t &pm, uint16_t &co2, int16_t &temp, uint16_t &humi,
+                        uint8_t &flags) {
+    pm = (i * 377) % 10000;
+    co2 = 400 + (i * 1543) % 40000;
+    temp = (int16_t)((i * 37) % 700) - 100;
+    humi = (i * 113) % 1001;
+    flags = i % 8 == 0 ? 0 : i % 8 == 1 ? SAMPLE_PM_VALID : SAMPLE_PM_VALID | SAMPLE_CO2_VALID;
+}
+
+static void frameGfx(uint32_t i) {
+    uint16_t pm, co2, humi;
+    int16_t temp;
+    uint8_t flags;
+    benchValues(i, pm, co2, temp, humi, flags);
+    drawValuesGfx(pm, co2, temp, humi, flags);
+}
+
+static void framePage(uint32_t i) {
+    uint16_t pm, co2, humi;
+    int16_t temp;
+    uint8_t flags;
+    benchValues(i, pm, co2, temp, humi, flags);
+    screenDrawValues(display.getBuffer(), pm, co2, temp, humi, flags);
+}
+
+// A detail screen: its layer plus three values
+static void frameClimate(uint32_t i) {
+    uint16_t pm, co2, humi;
+    int16_t temp;
+    uint8_t flags;
+    benchValues(i, pm, co2, temp, humi, flags);
+    screenDrawClimate(display.getBuffer(), co2, temp, humi, flags);
+}
+
+void screenBench() {
+    trendShown = false; // the bench draws into the frame
+    pageFontFromBuiltin(gfxSmallFont, SMALL_FONT_FIRST, SMALL_FONT_LAST, smallFontData);
+    if (!pageFontFromGfx(gfxValueFont, &FreeSans9pt7b, VALUE_FONT_FIRST, VALUE_FONT_LAST,
+                         valueFontData, sizeof(valueFontData))) {
+        halSerialPrintln("Value font doesn't fit VALUE_FONT_DATA");
+        return;
+    }
+    if (!screenPageFonts(&gfxValueFont, &gfxSmallFont)) {
+        halSerialPrintln("GFX fonts don't fit the atlas");
+    }
+
+    display.setTextColor(SSD1306_WHITE); // transparent text, as after showMessage()
+    display.setTextSize(1);
+    benchReport("frame gfx", benchCycles(frameGfx, SCREEN_BENCH_FRAMES));
+    benchReport("frame page", benchCycles(framePage, SCREEN_BENCH_FRAMES));
+
+    uint32_t differ = 0;
+    for (uint32_t i = 0; i < SCREEN_BENCH_FRAMES; i++) {
+        framePage(i);
+        memcpy(benchFrame, display.getBuffer(), sizeof(benchFrame));
+        frameGfx(i);
+        if (memcmp(benchFrame, display.getBuffer(), sizeof(benchFrame)) != 0) {
+            differ++;
+        }
+    }
+    char line[FMT_LINE_SIZE];
+    char *end = line + sizeof(line);
+    char *p = fmtStr(line, end, "bench frame page vs gfx: ");
+    p = fmtUint(p, end, differ);
+    p = fmtStr(p, end, " of ");
+    p = fmtUint(p, end, SCREEN_BENCH_FRAMES);
+    p = fmtStr(p, end, " frames differ");
+    halSerialPrintln(line);
+
+    screenPageFonts(&arialValueFont, &arialSmallFont);
+    benchReport("frame page arial", benchCycles(framePage, SCREEN_BENCH_FRAMES));
+    benchReport("frame climate", benchCycles(frameClimate, SCREEN_BENCH_FRAMES));
+    display.clearDisplay();
+}
@@ -0,0 +1,393 @@
+// enginair screen_page.cpp
+// Screen layouts in page format, see screen_page.h
+
+#include <string.h>
+#include "screen.h"
+#include "screen_page.h"
+#include "page_fonts.h"
+#include "symbols.h"
+#include "fmt.h"
+#include "sample.h"
+#include "history.h"
+
+// Glyphs pre-shifted for the two value baselines and the unit line: about
+// 810 bytes with the ArialMT fonts, a little more with the GFX ones
+#define ATLAS_DATA 1280
+static uint8_t atlasData[ATLAS_DATA];
+static page_atlas_t valueTop;
+static page_atlas_t valueBottom;
+static page_atlas_t smallUnit;
+
+static uint8_t ugm3Columns[16 * 2];
+static uint8_t degCColumns[8 * 1];
+static page_sprite_t iconUgm3 = {ugm3Columns, 16, 16, 0, 0, 0};
+static page_sprite_t iconDegC = {degCColumns, 8, 7, 0, 0, 0};
+static uint8_t degCCached[8 * 2];
+static page_cached_t iconDegCCached;
+
+// Positions as in the original GFX code, except "ppm": it sits on the top
+// value's baseline, raised a row so the descenders of 'p' (two rows) stay
+// above row 15, where the bottom line's '%' and the detail screens' rule
+// start.
+#define BOTLINE_Y 29
+#define TOPLINE_Y 14
+#define RIGHTHALF_X 64
+#define UNIT_Y (TOPLINE_Y - 1)
+#define DEGC_Y (BOTLINE_Y - 10)
+
+// Static parts of the detail screens
+enum screen_layer_t {
+    LAYER_PM,
+    LAYER_CLIMATE,
+    LAYER_STATS,
+    LAYER_AQI,
+    LAYERS
+};
+static uint8_t layers[LAYERS][OLED_BUFFER_SIZE];
+
+static void buildLayers();
+
+void screenPageBegin() {
+    pageTranspose(icon_ugm3, 0, 16, 16, 16, ugm3Columns);
+    pageTranspose(icon_degC, 0, 8, 8, 7, degCColumns);
+    pageCache(iconDegC, DEGC_Y, degCCached, iconDegCCached);
+    screenPageFonts(&arialValueFont, &arialSmallFont);
+    buildLayers();
+}
+
+bool screenPageFonts(const page_font_t *value, const page_font_t *small) {
+    uint8_t *pool = atlasData;
+    const uint8_t *end = atlasData + sizeof(atlasData);
+    bool ok = pageAtlasBuild(valueTop, *value, TOPLINE_Y, SCREEN_VALUE_CHARSET, pool, end);
+    ok &= pageAtlasBuild(valueBottom, *value, BOTLINE_Y, SCREEN_VALUE_CHARSET, pool, end);
+    ok &= pageAtlasBuild(smallUnit, *small, UNIT_Y, SCREEN_SMALL_CHARSET, pool, end);
+    return ok;
+}
+
+void screenDrawValues(uint8_t *frame, uint16_t pm2p5, uint16_t co2, int16_t temp, uint16_t humi,
+                      uint8_t flags) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    bool pm = flags & SAMPLE_PM_VALID;
+    bool co2Valid = flags & SAMPLE_CO2_VALID;
+
+    memset(frame, 0, OLED_BUFFER_SIZE);
+    page_cursor_t cursor = {0, TOPLINE_Y};
+    pm ? fmtFixed1(text, end, pm2p5) : fmtStr(text, end, NO_VALUE);
+    pageAtlasText(frame, valueTop, cursor, text);
+    pageBlit(frame, cursor.x + 2, 0, iconUgm3); // already page aligned
+
+    cursor = {RIGHTHALF_X, TOPLINE_Y};
+    co2Valid ? fmtUint(text, end, co2) : fmtStr(text, end, NO_VALUE);
+    pageAtlasText(frame, valueTop, cursor, text);
+    cursor.x += 1;
+    cursor.y = UNIT_Y;
+    pageAtlasText(frame, smallUnit, cursor, "ppm");
+
+    cursor = {0, BOTLINE_Y};
+    co2Valid ? fmtFixed1(text, end, temp) : fmtStr(text, end, NO_VALUE);
+    pageAtlasText(frame, valueBottom, cursor, text);
+    if (cursor.y == BOTLINE_Y) {
+        pageBlitCached(frame, cursor.x + 1, degCCached, iconDegCCached);
+    } else {
+        pageBlit(frame, cursor.x + 1, cursor.y - 10, iconDegC);
+    }
+
+    cursor = {RIGHTHALF_X, BOTLINE_Y};
+    co2Valid ? fmtFixed1(text, end, humi) : fmtStr(text, end, NO_VALUE);
+    pageAtlasText(frame, valueBottom, cursor, text);
+    pageAtlasText(frame, valueBottom, cursor, "%");
+}
+
+// --- Detail screens ---
+
+// Right edges of the values, and where the PM units go
+#define DETAIL_UNIT_X 112
+#define DETAIL_VALUE_RIGHT (DETAIL_UNIT_X - 4)
+#define CO2_RIGHT 100
+#define TEMP_RIGHT 48
+#define HUMI_RIGHT 112
+#define SEPARATOR_Y 15 // between the two value lines
+static_assert(UNIT_Y + 2 <= SEPARATOR_Y, "the ppm descenders reach the rule");
+#define STATS_LABEL_TOP 2
+#define STATS_LINE 16
+#define STATS_HALF_X 64
+
+// Every other pixel of row y from x0 to x1
+static void dottedRow(uint8_t *frame, uint8_t y, uint8_t x0, uint8_t x1) {
+    for (uint8_t x = x0; x <= x1; x += 2) {
+        frame[(y / 8) * OLED_WIDTH + x] |= 1 << (y & 7);
+    }
+}
+
+// Every other pixel of column x from y0 to y1
+static void dottedColumn(uint8_t *frame, uint8_t x, uint8_t y0, uint8_t y1) {
+    for (uint8_t y = y0; y <= y1; y += 2) {
+        frame[(y / 8) * OLED_WIDTH + x] |= 1 << (y & 7);
+    }
+}
+
+static void layerText(uint8_t *frame, const page_font_t &font, int16_t x, int16_t y, const char *text) {
+    page_cursor_t cursor = {x, y};
+    pageText(frame, font, cursor, text);
+}
+
+// Built once, so drawing speed doesn't matter here; the PM label icons are
+// only needed for it and are transposed on the stack
+static void buildLayers() {
+    memset(layers, 0, sizeof(layers));
+
+    uint8_t *frame = layers[LAYER_PM];
+    uint8_t pm25Columns[16];
+    uint8_t pm10Columns[16];
+    pageTranspose(icon_pm25, 0, 16, 16, 7, pm25Columns);
+    pageTranspose(icon_pm10, 0, 16, 16, 7, pm10Columns);
+    pageBlit(frame, 0, 4, {pm25Columns, 16, 7, 0, 0, 0});
+    pageBlit(frame, 0, 20, {pm10Columns, 16, 7, 0, 0, 0});
+    pageBlit(frame, DETAIL_UNIT_X, 0, iconUgm3);
+    pageBlit(frame, DETAIL_UNIT_X, 16, iconUgm3);
+    dottedRow(frame, SEPARATOR_Y, 0, OLED_WIDTH - 1);
+
+    frame = layers[LAYER_CLIMATE];
+    page_cursor_t cursor = {0, STATS_LABEL_TOP};
+    pageText(frame, arialLabelFont, cursor, "CO");
+    cursor.y += 2; // subscript
+    pageText(frame, arialDigitFont, cursor, "2");
+    layerText(frame, arialSmallFont, CO2_RIGHT + 2, UNIT_Y, "ppm"); // on the CO2 digits' baseline
+    pageBlit(frame, TEMP_RIGHT + 1, DEGC_Y, iconDegC);
+    layerText(frame, arialValueFont, HUMI_RIGHT, BOTLINE_Y, "%");
+    dottedRow(frame, SEPARATOR_Y, 0, OLED_WIDTH - 1);
+
+    frame = layers[LAYER_STATS];
+    layerText(frame, arialLabelFont, 0, STATS_LABEL_TOP, "UP");
+    layerText(frame, arialLabelFont, STATS_HALF_X + 2, STATS_LABEL_TOP, "BOOT");
+    layerText(frame, arialLabelFont, 0, STATS_LINE + STATS_LABEL_TOP, "LOG");
+    layerText(frame, arialLabelFont, STATS_HALF_X + 2, STATS_LINE + STATS_LABEL_TOP, "DROP");
+    dottedRow(frame, STATS_LINE - 1, 0, OLED_WIDTH - 1);
+    dottedColumn(frame, STATS_HALF_X - 1, 0, OLED_HEIGHT - 1);
+
+    // US AQI over the left half, EU CAQI 1 h and 24 h on the right
+    frame = layers[LAYER_AQI];
+    layerText(frame, arialLabelFont, 0, STATS_LABEL_TOP, "AQI");
+    const char *const spans[] = {"1", "24"};
+    for (uint8_t i = 0; i < 2; i++) {
+        cursor = {STATS_HALF_X + 2, (int16_t)(i * STATS_LINE + STATS_LABEL_TOP)};
+        pageText(frame, arialLabelFont, cursor, "EU");
+        cursor.x += 3;
+        pageText(frame, arialDigitFont, cursor, spans[i]);
+        pageText(frame, arialLabelFont, cursor, "H");
+    }
+    dottedRow(frame, STATS_LINE - 1, STATS_HALF_X, OLED_WIDTH - 1);
+    dottedColumn(frame, STATS_HALF_X - 1, 0, OLED_HEIGHT - 1);
+}
+
+// Text ending at x = right, through an atlas (so on its baseline)
+static void atlasRight(uint8_t *frame, const page_atlas_t &atlas, int16_t right, const char *text) {
+    page_cursor_t cursor = {(int16_t)(right - pageTextWidth(*atlas.font, text)), atlas.y};
+    pageAtlasText(frame, atlas, cursor, text);
+}
+
+void screenDrawPM(uint8_t *frame, uint16_t pm2p5, uint16_t pm10p0, uint8_t flags) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    bool pm = flags & SAMPLE_PM_VALID;
+
+    memcpy(frame, layers[LAYER_PM], OLED_BUFFER_SIZE);
+    pm ? fmtFixed1(text, end, pm2p5) : fmtStr(text, end, NO_VALUE);
+    atlasRight(frame, valueTop, DETAIL_VALUE_RIGHT, text);
+    pm ? fmtFixed1(text, end, pm10p0) : fmtStr(text, end, NO_VALUE);
+    atlasRight(frame, valueBottom, DETAIL_VALUE_RIGHT, text);
+}
+
+void screenDrawClimate(uint8_t *frame, uint16_t co2, int16_t temp, uint16_t humi, uint8_t flags) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    bool valid = flags & SAMPLE_CO2_VALID;
+
+    memcpy(frame, layers[LAYER_CLIMATE], OLED_BUFFER_SIZE);
+    valid ? fmtUint(text, end, co2) : fmtStr(text, end, NO_VALUE);
+    atlasRight(frame, valueTop, CO2_RIGHT, text);
+    valid ? fmtFixed1(text, end, temp) : fmtStr(text, end, NO_VALUE);
+    atlasRight(frame, valueBottom, TEMP_RIGHT, text);
+    valid ? fmtFixed1(text, end, humi) : fmtStr(text, end, NO_VALUE);
+    atlasRight(frame, valueBottom, HUMI_RIGHT, text);
+}
+
+// Small number ending at x = right, level with the labels of line y
+static void statsValue(uint8_t *frame, int16_t right, int16_t y, const char *text) {
+    layerText(frame, arialDigitFont, right - pageTextWidth(arialDigitFont, text), y, text);
+}
+
+void screenDrawStats(uint8_t *frame, const screen_stats_t &stats) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    const int16_t top = STATS_LABEL_TOP;
+    const int16_t bottom = STATS_LINE + STATS_LABEL_TOP;
+
+    memcpy(frame, layers[LAYER_STATS], OLED_BUFFER_SIZE);
+    // Uptime as h:mm
+    uint32_t minutes = stats.uptime / 60 % 60;
+    char *p = fmtUint(text, end, stats.uptime / 3600);
+    p = fmtStr(p, end, minutes < 10 ? ":0" : ":");
+    fmtUint(p, end, minutes);
+    statsValue(frame, STATS_HALF_X - 4, top, text);
+
+    fmtUint(text, end, stats.boot);
+    statsValue(frame, OLED_WIDTH - 1, top, text);
+    fmtUint(text, end, stats.records);
+    statsValue(frame, STATS_HALF_X - 4, bottom, text);
+    fmtUint(text, end, stats.dropped);
+    statsValue(frame, OLED_WIDTH - 1, bottom, text);
+}
+
+void screenDrawAQI(uint8_t *frame, const aqi_t &aqi) {
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+
+    memcpy(frame, layers[LAYER_AQI], OLED_BUFFER_SIZE);
+    aqi.us == AQI_INVALID ? fmtStr(text, end, NO_VALUE) : fmtUint(text, end, aqi.us);
+    atlasRight(frame, valueBottom, STATS_HALF_X - 4, text);
+    aqi.caqiHour == AQI_INVALID ? fmtStr(text, end, NO_VALUE) : fmtUint(text, end, aqi.caqiHour);
+    statsValue(frame, OLED_WIDTH - 1, STATS_LABEL_TOP, text);
+    aqi.caqiDay == AQI_INVALID ? fmtStr(text, end, NO_VALUE) : fmtUint(text, end, aqi.caqiDay);
+    statsValue(frame, OLED_WIDTH - 1, STATS_LINE + STATS_LABEL_TOP, text);
+}
+
+// --- Trend ---
+
+// Graph columns TREND_X..127, one per sample, the newest value printed to
+// their left. Values are clamped to fixed scales (a rescale would mean
+// redrawing every column): PM2.5 0..35 ug/m3, the US "moderate" limit, and
+// CO2 400..1400 ppm, outdoor air up to "poor". The top row of each half
+// stays clear to keep the graphs apart.
+#define TREND_X 40
+#define TREND_POINTS (OLED_WIDTH - TREND_X)
+#define TREND_ROWS 15
+#define TREND_PM_TOP 350 // PM ticks
+#define TREND_CO2_BOTTOM 400
+#define TREND_CO2_TOP 1400
+
+struct trend_graph_t {
+    history_channel_t channel;
+    uint8_t page;    // first of its two pages
+    uint16_t bottom; // value drawn on the lowest row
+    uint16_t top;
+};
+
+static const trend_graph_t trendGraphs[] = {
+    {CH_PM2P5, 0, 0, TREND_PM_TOP},
+    {CH_CO2, 2, TREND_CO2_BOTTOM, TREND_CO2_TOP},
+};
+
+static uint32_t trendSamples; // historySamples() as last drawn
+static trend_mode_t trendMode;
+
+// Row within the half, 1 (top) .. TREND_ROWS
+static uint8_t trendRow(const trend_graph_t &graph, uint16_t value) {
+    value = value < graph.bottom ? graph.bottom : value > graph.top ? graph.top : value;
+    return TREND_ROWS - (uint32_t)(value - graph.bottom) * (TREND_ROWS - 1) / (graph.top - graph.bottom);
+}
+
+static uint16_t trendValue(const trend_graph_t &graph, uint16_t age) {
+    history_bucket_t point;
+    return historyGet(0, age, point) ? point.mean[graph.channel] : HISTORY_INVALID;
+}
+
+// Draw the point of the given age in column x, joined to the one before it
+// by a vertical run. Both pages of the column are overwritten.
+static void trendColumn(uint8_t *frame, uint8_t x, const trend_graph_t &graph, uint16_t age) {
+    uint16_t value = trendValue(graph, age);
+    uint16_t previous = trendValue(graph, age + 1);
+    uint16_t bits = 0; // bit 0 is the top row of the half
+    if (value != HISTORY_INVALID) {
+        uint8_t from = trendRow(graph, value);
+        uint8_t to = from;
+        if (previous != HISTORY_INVALID) {
+            uint8_t row = trendRow(graph, previous);
+            from = row < from ? row : from;
+            to = row > to ? row : to;
+        }
+        bits = (uint16_t)((2u << to) - (1u << from));
+    }
+    frame[graph.page * OLED_WIDTH + x] = bits;
+    frame[(graph.page + 1) * OLED_WIDTH + x] = bits >> 8;
+}
+
+// Column of the sample with the given number in sweep mode
+static uint8_t trendSweepX(uint32_t sample) {
+    return TREND_X + sample % TREND_POINTS;
+}
+
+static void trendRedraw(uint8_t *frame, trend_mode_t mode, uint32_t samples) {
+    memset(frame, 0, OLED_BUFFER_SIZE);
+    uint16_t count = historyCount(0);
+    // Sweep leaves one column free for the gap
+    uint16_t points = mode == TREND_SWEEP ? TREND_POINTS - 1 : TREND_POINTS;
+    for (uint16_t age = 0; age < points && age < count; age++) {
+        uint8_t x = mode == TREND_SWEEP ? trendSweepX(samples - 1 - age) : OLED_WIDTH - 1 - age;
+        for (const trend_graph_t &graph : trendGraphs) {
+            trendColumn(frame, x, graph, age);
+        }
+    }
+}
+
+// The newest sample into a frame holding the one before it
+static void trendAdvance(uint8_t *frame, trend_mode_t mode, uint32_t samples) {
+    if (mode == TREND_SWEEP) {
+        uint8_t x = trendSweepX(samples - 1);
+        uint8_t gap = trendSweepX(samples);
+        for (const trend_graph_t &graph : trendGraphs) {
+            trendColumn(frame, x, graph, 0);
+            frame[graph.page * OLED_WIDTH + gap] = 0;
+            frame[(graph.page + 1) * OLED_WIDTH + gap] = 0;
+        }
+        return;
+    }
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        uint8_t *row = frame + page * OLED_WIDTH + TREND_X;
+        memmove(row, row + 1, TREND_POINTS - 1);
+    }
+    for (const trend_graph_t &graph : trendGraphs) {
+        trendColumn(frame, OLED_WIDTH - 1, graph, 0);
+    }
+}
+
+// Newest values left of the graphs, in whole ug/m3 from 100 and capped at
+// four digits so they never reach into the graph area (which scrolls)
+static void trendLabels(uint8_t *frame) {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        memset(frame + page * OLED_WIDTH, 0, TREND_X);
+    }
+    char text[FMT_FIELD_SIZE];
+    char *end = text + sizeof(text);
+    uint16_t pm = trendValue(trendGraphs[0], 0);
+    if (pm == HISTORY_INVALID) {
+        fmtStr(text, end, NO_VALUE);
+    } else if (pm < 1000) {
+        fmtFixed1(text, end, pm);
+    } else {
+        fmtUint(text, end, pm / 10 > 9999 ? 9999 : pm / 10);
+    }
+    page_cursor_t cursor = {0, TOPLINE_Y};
+    pageAtlasText(frame, valueTop, cursor, text);
+
+    uint16_t co2 = trendValue(trendGraphs[1], 0);
+    co2 == HISTORY_INVALID ? fmtStr(text, end, NO_VALUE) : fmtUint(text, end, co2 > 9999 ? 9999 : co2);
+    cursor = {0, BOTLINE_Y};
+    pageAtlasText(frame, valueBottom, cursor, text);
+}
+
+void screenDrawTrend(uint8_t *frame, trend_mode_t mode, bool onScreen) {
+    uint32_t samples = historySamples();
+    if (onScreen && mode == trendMode && samples == trendSamples) {
+        return; // nothing new
+    }
+    if (onScreen && mode == trendMode && samples == trendSamples + 1 && historyCount(0) > 1) {
+        trendAdvance(frame, mode, samples);
+    } else {
+        trendRedraw(frame, mode, samples);
+    }
+    trendLabels(frame);
+    trendSamples = samples;
+    trendMode = mode;
+}
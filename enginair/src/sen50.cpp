@@ -0,0 +1,167 @@
+// enginair sen50.cpp
+// Non-blocking SEN50 driver, see sen50.h
+
+#include "hal.h"
+#include "sen50.h"
+
+// Commands and execution times from the SEN5x datasheet
+#define SEN5X_CMD_DEVICE_RESET 0xD304
+#define SEN5X_CMD_START_MEASUREMENT 0x0021
+#define SEN5X_CMD_STOP_MEASUREMENT 0x0104
+#define SEN5X_CMD_DATA_READY 0x0202
+#define SEN5X_CMD_READ_VALUES 0x03C4
+#define SEN5X_RESET_US 100000
+#define SEN5X_START_US 50000
+#define SEN5X_STOP_US 200000
+#define SEN5X_DATA_READY_US 20000
+#define SEN5X_READ_US 20000
+#define SEN5X_READ_WORDS 8 // PM1.0, PM2.5, PM4.0, PM10, RH, T, VOC, NOx
+
+driver_event_t Sen50::fail(uint16_t err, const char *context, state_t next) {
+    error = err;
+    errorContext = context;
+    state = next;
+    return DRIVER_ERROR;
+}
+
+void Sen50::begin() {
+    readRequested = false;
+    pendingError = sensirionIssue(dev, SEN5X_CMD_DEVICE_RESET, SEN5X_RESET_US);
+    if (pendingError) {
+        pendingContext = "Error resetting SEN50: ";
+        dev.readyAt = halMicros(); // report it, then try to start anyway
+    }
+    state = RESETTING;
+}
+
+void Sen50::stopMeasurement() {
+    if (state != MEASURING) {
+        return;
+    }
+    readRequested = false;
+    pendingError = sensirionIssue(dev, SEN5X_CMD_STOP_MEASUREMENT, SEN5X_STOP_US);
+    if (pendingError) {
+        pendingContext = "Error stopping SEN50 measurement: "; // still measuring
+        return;
+    }
+    state = STOPPING;
+}
+
+void Sen50::startMeasurement() {
+    if (state != IDLE) {
+        return;
+    }
+    readRequested = false; // a request from before the stop would read a warming sensor
+    pendingError = sensirionIssue(dev, SEN5X_CMD_START_MEASUREMENT, SEN5X_START_US);
+    if (pendingError) {
+        pendingContext = "Error starting SEN50 measurement: "; // still idle
+        return;
+    }
+    state = STARTING;
+}
+
+void Sen50::requestRead(bool ifReady) {
+    readRequested = true;
+    checkReady = ifReady;
+}
+
+driver_event_t Sen50::poll(uint32_t now) {
+    uint16_t words[SEN5X_READ_WORDS];
+    uint16_t err;
+
+    if (pendingError) {
+        err = pendingError;
+        pendingError = 0;
+        return fail(err, pendingContext, state);
+    }
+
+    switch (state) {
+        case OFF:
+        case IDLE:
+            return DRIVER_NONE;
+
+        case RESETTING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            sensirionFetch(dev, words);
+            err = sensirionIssue(dev, SEN5X_CMD_START_MEASUREMENT, SEN5X_START_US);
+            if (err) {
+                return fail(err, "Error starting SEN50 measurement: ", OFF);
+            }
+            state = STARTING;
+            return DRIVER_NONE;
+
+        case STOPPING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            sensirionFetch(dev, words);
+            state = IDLE;
+            return DRIVER_NONE;
+
+        case STARTING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            sensirionFetch(dev, words);
+            state = MEASURING;
+            return DRIVER_STARTED;
+
+        case MEASURING:
+            if (!readRequested) {
+                return DRIVER_NONE;
+            }
+            readRequested = false;
+            if (checkReady) {
+                err = sensirionIssue(dev, SEN5X_CMD_DATA_READY, SEN5X_DATA_READY_US, 1);
+                if (err) {
+                    return fail(err, "Couldn't get SEN50 data ready flag: ", MEASURING);
+                }
+                state = CHECKING;
+                return DRIVER_NONE;
+            }
+            err = sensirionIssue(dev, SEN5X_CMD_READ_VALUES, SEN5X_READ_US, SEN5X_READ_WORDS);
+            if (err) {
+                return fail(err, "Error reading measured values from SEN50: ", MEASURING);
+            }
+            state = READING;
+            return DRIVER_NONE;
+
+        case CHECKING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            err = sensirionFetch(dev, words);
+            if (err) {
+                return fail(err, "Couldn't get SEN50 data ready flag: ", MEASURING);
+            }
+            if (!(words[0] & 0xFF)) { // flag is the second byte
+                state = MEASURING;
+                return DRIVER_NOT_READY;
+            }
+            err = sensirionIssue(dev, SEN5X_CMD_READ_VALUES, SEN5X_READ_US, SEN5X_READ_WORDS);
+            if (err) {
+                return fail(err, "Error reading measured values from SEN50: ", MEASURING);
+            }
+            state = READING;
+            return DRIVER_NONE;
+
+        case READING:
+            if (!sensirionDone(dev, now)) {
+                return DRIVER_NONE;
+            }
+            state = MEASURING;
+            err = sensirionFetch(dev, words);
+            if (err) {
+                return fail(err, "Error reading measured values from SEN50: ", MEASURING);
+            }
+            // SEN50 has no VOC, NOx, humidity or temperature sensor.
+            pm1p0 = words[0];
+            pm2p5 = words[1];
+            pm4p0 = words[2];
+            pm10p0 = words[3];
+            return DRIVER_SAMPLE;
+    }
+    return DRIVER_NONE;
+}
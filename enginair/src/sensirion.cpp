@@ -0,0 +1,113 @@
+// enginair sensirion.cpp
+// Split-phase Sensirion I2C commands, see sensirion.h
+
+#include "hal.h"
+#include "sensirion.h"
+#include "i2c_bus.h"
+#include "scheduler.h"
+#include "trace.h"
+
+#define SENSIRION_CRC_POLY 0x31
+#define SENSIRION_CRC_INIT 0xFF
+
+uint8_t sensirionCrc(const uint8_t *data, uint8_t len) {
+    uint8_t crc = SENSIRION_CRC_INIT;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ SENSIRION_CRC_POLY : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t sensirionIssue(sensirion_dev_t &dev, uint16_t cmd, uint32_t execUs, uint8_t words,
+                        const uint16_t *args, uint8_t nargs) {
+    uint32_t now = halMicros();
+    if (dev.command && !sensirionDone(dev, now)) {
+        return SENSIRION_ERR_BUSY;
+    }
+
+    if (nargs > SENSIRION_MAX_ARGS) {
+        nargs = SENSIRION_MAX_ARGS;
+    }
+    uint8_t buffer[2 + SENSIRION_MAX_ARGS * 3];
+    uint8_t length = 0;
+    buffer[length++] = cmd >> 8;
+    buffer[length++] = cmd & 0xFF;
+    for (uint8_t i = 0; i < nargs; i++) {
+        uint8_t *word = buffer + length;
+        word[0] = args[i] >> 8;
+        word[1] = args[i] & 0xFF;
+        word[2] = sensirionCrc(word, 2);
+        length += 3;
+    }
+
+    uint8_t status;
+    {
+        I2CBusGuard bus;
+        status = i2cWrite(dev.address, buffer, length);
+    }
+    traceI2C(dev.address, TRACE_WRITE, status, buffer, length);
+    if (status) {
+        dev.command = 0;
+        dev.words = 0;
+        return (status << 8) | SENSIRION_ERR_WRITE;
+    }
+
+    dev.command = cmd;
+    dev.words = words;
+    dev.readyAt = now + execUs;
+    schedulerWakeAt(dev.readyAt);
+    return SENSIRION_OK;
+}
+
+bool sensirionDone(const sensirion_dev_t &dev, uint32_t now) {
+    return (int32_t)(now - dev.readyAt) >= 0;
+}
+
+uint16_t sensirionFetch(sensirion_dev_t &dev, uint16_t *out) {
+    uint8_t words = dev.command ? dev.words : 0;
+    dev.command = 0;
+    if (words == 0) {
+        return SENSIRION_OK;
+    }
+
+    uint8_t raw[SENSIRION_MAX_WORDS * 3];
+    uint8_t len = words * 3;
+    uint8_t n;
+    {
+        I2CBusGuard bus;
+        n = i2cRead(dev.address, raw, len);
+    }
+    traceI2C(dev.address, TRACE_READ, n, raw, n);
+    if (n != len) {
+        return SENSIRION_ERR_READ;
+    }
+
+    for (uint8_t i = 0; i < words; i++) {
+        const uint8_t *word = raw + i * 3;
+        if (sensirionCrc(word, 2) != word[2]) {
+            return SENSIRION_ERR_CRC;
+        }
+        out[i] = (word[0] << 8) | word[1];
+    }
+    return SENSIRION_OK;
+}
+
+const char *sensirionErrorString(uint16_t error) {
+    switch (error & 0xFF) {
+        case SENSIRION_OK:
+            return "no error";
+        case SENSIRION_ERR_WRITE:
+            return "I2C write failed (NACK)";
+        case SENSIRION_ERR_READ:
+            return "I2C read returned too few bytes";
+        case SENSIRION_ERR_CRC:
+            return "CRC mismatch";
+        case SENSIRION_ERR_BUSY:
+            return "command still executing";
+        default:
+            return "unknown error";
+    }
+}
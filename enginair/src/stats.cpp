@@ -0,0 +1,28 @@
+// enginair stats.cpp
+// Statistic selection, see stats.h
+
+#include "stats.h"
+
+static const char *const viewNames[STATS_VIEWS] = {
+    "raw", "fast", "mid", "slow", "min", "max", "median", "p90"
+};
+
+const char *statsViewName(stats_view_t view) {
+    return view < STATS_VIEWS ? viewNames[view] : "?";
+}
+
+uint16_t statsView(const stats_summary_t &summary, stats_view_t view, uint16_t raw) {
+    if (summary.count == 0) {
+        return raw;
+    }
+    switch (view) {
+        case STATS_FAST: return summary.fast;
+        case STATS_MID: return summary.mid;
+        case STATS_SLOW: return summary.slow;
+        case STATS_MIN: return summary.min;
+        case STATS_MAX: return summary.max;
+        case STATS_MEDIAN: return summary.median;
+        case STATS_P90: return summary.p90;
+        default: return raw;
+    }
+}
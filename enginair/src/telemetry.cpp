@@ -0,0 +1,143 @@
+// enginair telemetry.cpp
+// COBS framed binary telemetry, see telemetry.h
+
+#include "hal.h"
+#include <string.h>
+#include "telemetry.h"
+#include "crc16.h"
+
+static_assert(sizeof(telemetry_sample_t) == 21, "sample message layout changed");
+static_assert(sizeof(telemetry_stats_t) <= TELEMETRY_MAX_BODY, "stats message too long");
+static_assert(sizeof(telemetry_pm_stats_t) == 20, "PM stats message layout changed");
+static_assert(sizeof(telemetry_aqi_t) == 23, "AQI message layout changed");
+
+#define TELEMETRY_HEADER 2
+#define TELEMETRY_CRC 2
+#define TELEMETRY_MAX_MESSAGE (TELEMETRY_HEADER + TELEMETRY_MAX_BODY + TELEMETRY_CRC)
+// COBS adds one byte per 254, plus the two delimiters
+#define TELEMETRY_MAX_FRAME (TELEMETRY_MAX_MESSAGE + TELEMETRY_MAX_MESSAGE / 254 + 3)
+
+#ifdef ENGINAIR_CAPTURE
+volatile telemetry_mode_t telemetryMode = TELEMETRY_BINARY; // trace.h
+#else
+volatile telemetry_mode_t telemetryMode = TELEMETRY_TEXT;
+#endif
+
+static uint16_t sampleSequence = 0; // core 1 only
+static aqi_t lastAqi;               // core 1 only, last sent
+
+// Consistent Overhead Byte Stuffing: no zero bytes in the output, so 0x00
+// can delimit frames. Returns the encoded length.
+static uint32_t cobsEncode(const uint8_t *in, uint32_t length, uint8_t *out) {
+    uint32_t code = 0; // where the current block's length byte goes
+    uint32_t o = 1;
+    uint8_t run = 1;
+    for (uint32_t i = 0; i < length; i++) {
+        if (in[i] == 0) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++run == 0xFF) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+        }
+    }
+    out[code] = run;
+    return o;
+}
+
+void telemetrySend(uint8_t type, const void *body, uint8_t length) {
+    if (length > TELEMETRY_MAX_BODY) {
+        length = TELEMETRY_MAX_BODY;
+    }
+
+    uint8_t message[TELEMETRY_MAX_MESSAGE];
+    message[0] = TELEMETRY_VERSION;
+    message[1] = type;
+    memcpy(message + TELEMETRY_HEADER, body, length);
+    uint32_t n = TELEMETRY_HEADER + length;
+    uint16_t crc = crc16(CRC16_INIT, message, n);
+    message[n++] = crc & 0xFF;
+    message[n++] = crc >> 8;
+
+    // Delimit on both sides, so the frame survives any text sent just before
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    frame[0] = 0;
+    uint32_t size = 1 + cobsEncode(message, n, frame + 1);
+    frame[size++] = 0;
+    halSerialWrite(frame, size);
+}
+
+// The PM2.5 statistics, once there are any
+static void sendPmStats(const sample_t &sample) {
+    const stats_summary_t &stats = sample.pm2p5Stats;
+    if (stats.count == 0) {
+        return;
+    }
+    telemetry_pm_stats_t body;
+    body.time = sample.time;
+    body.count = stats.count;
+    body.fast = stats.fast;
+    body.mid = stats.mid;
+    body.slow = stats.slow;
+    body.min = stats.min;
+    body.max = stats.max;
+    body.median = stats.median;
+    body.p90 = stats.p90;
+    telemetrySend(TELEMETRY_PM_STATS, &body, sizeof(body));
+}
+
+// The indices, when they changed since the last frame
+static void sendAqi(const sample_t &sample) {
+    const aqi_t &aqi = sample.aqi;
+    if (aqi.pm2p5Hour == AQI_INVALID || memcmp(&aqi, &lastAqi, sizeof(aqi)) == 0) {
+        return;
+    }
+    lastAqi = aqi;
+    telemetry_aqi_t body;
+    body.time = sample.time;
+    body.pm2p5Hour = aqi.pm2p5Hour;
+    body.pm2p5Day = aqi.pm2p5Day;
+    body.pm10Hour = aqi.pm10Hour;
+    body.pm10Day = aqi.pm10Day;
+    body.pm2p5NowCast = aqi.pm2p5NowCast;
+    body.pm10NowCast = aqi.pm10NowCast;
+    body.us = aqi.us;
+    body.usCategory = aqi.usCategory;
+    body.caqiHour = aqi.caqiHour;
+    body.caqiDay = aqi.caqiDay;
+    telemetrySend(TELEMETRY_AQI, &body, sizeof(body));
+}
+
+void telemetrySample(const sample_t &sample) {
+    telemetry_sample_t body;
+    body.sequence = sampleSequence++;
+    body.time = sample.time;
+    body.flags = sample.flags;
+    body.pm1p0 = sample.pm1p0;
+    body.pm2p5 = sample.pm2p5;
+    body.pm4p0 = sample.pm4p0;
+    body.pm10p0 = sample.pm10p0;
+    body.co2 = sample.co2;
+    body.temp = sample.temp;
+    body.humi = sample.humi;
+    telemetrySend(TELEMETRY_SAMPLE, &body, sizeof(body));
+    sendPmStats(sample);
+    sendAqi(sample);
+}
+
+void telemetryError(const char *context, uint16_t code) {
+    uint8_t body[TELEMETRY_MAX_BODY];
+    telemetry_error_t error = {code};
+    memcpy(body, &error, sizeof(error));
+    uint32_t length = strlen(context);
+    if (length > sizeof(body) - sizeof(error)) {
+        length = sizeof(body) - sizeof(error);
+    }
+    memcpy(body + sizeof(error), context, length);
+    telemetrySend(TELEMETRY_ERROR, body, sizeof(error) + length);
+}
@@ -0,0 +1,68 @@
+// enginair trace.cpp
+// Sensor traffic capture, see trace.h
+
+#include <string.h>
+#include "hal.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "spsc_queue.h"
+
+struct trace_entry_t {
+    uint32_t time;
+    uint8_t address;
+    uint8_t op;
+    uint8_t result;
+    uint8_t length;
+    uint8_t data[TRACE_MAX_DATA];
+};
+
+static_assert(sizeof(telemetry_trace_t) + TRACE_MAX_DATA <= TELEMETRY_MAX_BODY, "trace frame too long");
+
+// Deep enough for the boot sequence, which happens before USB is up
+static SpscQueue<trace_entry_t, 64> traceQueue;
+static uint16_t traceSequence = 0; // core 1 only
+
+#ifdef ENGINAIR_CAPTURE
+volatile bool traceCapture = true;
+#else
+volatile bool traceCapture = false;
+#endif
+
+void traceI2C(uint8_t address, uint8_t op, uint8_t result, const uint8_t *data, uint8_t length) {
+    if (!traceCapture) {
+        return;
+    }
+    trace_entry_t entry;
+    entry.time = halMicros();
+    entry.address = address;
+    entry.op = op;
+    entry.result = result;
+    entry.length = length < TRACE_MAX_DATA ? length : TRACE_MAX_DATA;
+    memcpy(entry.data, data, entry.length);
+    if (traceQueue.push(entry)) {
+        halSignalEvent(); // wake core 1
+    }
+}
+
+void tracePoll() {
+    if (!halSerialConnected()) {
+        return;
+    }
+    trace_entry_t entry;
+    while (traceQueue.pop(entry)) {
+        uint8_t body[TELEMETRY_MAX_BODY];
+        telemetry_trace_t header;
+        header.sequence = traceSequence++;
+        header.time = entry.time;
+        header.address = entry.address;
+        header.op = entry.op;
+        header.result = entry.result;
+        memcpy(body, &header, sizeof(header));
+        memcpy(body + sizeof(header), entry.data, entry.length);
+        telemetrySend(TELEMETRY_TRACE, body, sizeof(header) + entry.length);
+    }
+}
+
+uint32_t traceDropped() {
+    return traceQueue.dropped();
+}
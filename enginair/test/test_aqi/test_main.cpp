@@ -0,0 +1,210 @@
+// enginair test_aqi
+// Air quality indices (aqi.h): the breakpoint tables at their band edges,
+// the 75% rule for the running means, readings covering their sample
+// period, and the NowCast against the EPA formula in floating point.
+
+#include <unity.h>
+#include <math.h>
+#include "aqi.h"
+
+#define SECOND_US 1000000u
+
+static AqiEngine engine;
+static uint32_t now;
+
+void setUp() {
+    engine.clear();
+    now = 1000; // micros, any start will do
+}
+
+void tearDown() {}
+
+// Readings of pm2p5/pm10 every period seconds for the given seconds, each
+// standing for its period
+static void feed(uint16_t pm2p5, uint16_t pm10, uint32_t seconds, uint32_t period = 1) {
+    for (uint32_t t = 0; t < seconds; t += period) {
+        engine.add(now, pm2p5, pm10, period * SECOND_US);
+        now += period * SECOND_US;
+    }
+    engine.advance(now);
+}
+
+// No readings for the given seconds
+static void gap(uint32_t seconds) {
+    for (uint32_t t = 0; t < seconds; t++) {
+        now += SECOND_US;
+        engine.advance(now);
+    }
+}
+
+// US AQI, PM2.5 (2024): both ends of every band, and the top
+static void test_us_pm2p5_breakpoints() {
+    static const uint16_t conc[] = {0, 90, 91, 354, 355, 554, 555, 1254, 1255, 2254, 2255, 3254};
+    static const uint16_t index[] = {0, 50, 51, 100, 101, 150, 151, 200, 201, 300, 301, 500};
+    for (uint8_t i = 0; i < sizeof(conc) / sizeof(conc[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT16(index[i], aqiUsPm2p5(conc[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT16(53, aqiUsPm2p5(100));  // 51 + 49 * 9 / 263, rounded
+    TEST_ASSERT_EQUAL_UINT16(500, aqiUsPm2p5(5000)); // stays at the top
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, aqiUsPm2p5(AQI_INVALID));
+}
+
+// US AQI, PM10: whole ug/m3, so 54.9 is still in the first band
+static void test_us_pm10_breakpoints() {
+    TEST_ASSERT_EQUAL_UINT16(0, aqiUsPm10(0));
+    TEST_ASSERT_EQUAL_UINT16(50, aqiUsPm10(540));
+    TEST_ASSERT_EQUAL_UINT16(50, aqiUsPm10(549));
+    TEST_ASSERT_EQUAL_UINT16(51, aqiUsPm10(550));
+    TEST_ASSERT_EQUAL_UINT16(100, aqiUsPm10(1540));
+    TEST_ASSERT_EQUAL_UINT16(101, aqiUsPm10(1550));
+    TEST_ASSERT_EQUAL_UINT16(500, aqiUsPm10(6040));
+    TEST_ASSERT_EQUAL_UINT16(500, aqiUsPm10(9000));
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, aqiUsPm10(AQI_INVALID));
+}
+
+// CAQI: the higher sub-index, shared grid edges, and past the top grid value
+// at the last band's slope
+static void test_caqi_breakpoints() {
+    TEST_ASSERT_EQUAL_UINT16(25, aqiCaqiHourly(150, 0));
+    TEST_ASSERT_EQUAL_UINT16(75, aqiCaqiHourly(550, 250));
+    TEST_ASSERT_EQUAL_UINT16(75, aqiCaqiHourly(0, 900));
+    TEST_ASSERT_EQUAL_UINT16(100, aqiCaqiHourly(1100, 0));
+    TEST_ASSERT_EQUAL_UINT16(150, aqiCaqiHourly(2200, 0));
+    TEST_ASSERT_EQUAL_UINT16(50, aqiCaqiHourly(AQI_INVALID, 500));
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, aqiCaqiHourly(AQI_INVALID, AQI_INVALID));
+
+    TEST_ASSERT_EQUAL_UINT16(25, aqiCaqiDaily(100, 150));
+    TEST_ASSERT_EQUAL_UINT16(100, aqiCaqiDaily(600, 0));
+    TEST_ASSERT_EQUAL_UINT16(100, aqiCaqiDaily(0, 1000));
+}
+
+static void test_categories() {
+    TEST_ASSERT_EQUAL(AQI_GOOD, aqiUsCategory(0));
+    TEST_ASSERT_EQUAL(AQI_GOOD, aqiUsCategory(50));
+    TEST_ASSERT_EQUAL(AQI_MODERATE, aqiUsCategory(51));
+    TEST_ASSERT_EQUAL(AQI_SENSITIVE, aqiUsCategory(150));
+    TEST_ASSERT_EQUAL(AQI_UNHEALTHY, aqiUsCategory(151));
+    TEST_ASSERT_EQUAL(AQI_VERY_UNHEALTHY, aqiUsCategory(300));
+    TEST_ASSERT_EQUAL(AQI_HAZARDOUS, aqiUsCategory(500));
+    TEST_ASSERT_EQUAL(AQI_CATEGORIES, aqiUsCategory(AQI_INVALID));
+    TEST_ASSERT_EQUAL_STRING("moderate", aqiCategoryName(AQI_MODERATE));
+    TEST_ASSERT_EQUAL_STRING("--", aqiCategoryName(AQI_CATEGORIES));
+}
+
+// The hourly mean needs 45 of its 60 minutes
+static void test_hour_mean_needs_75_percent() {
+    feed(100, 200, 44 * 60);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, engine.result().pm2p5Hour);
+    feed(100, 200, 60);
+    aqi_t aqi = engine.result();
+    TEST_ASSERT_EQUAL_UINT16(100, aqi.pm2p5Hour);
+    TEST_ASSERT_EQUAL_UINT16(200, aqi.pm10Hour);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, aqi.pm2p5NowCast);
+
+    // A 10 minute dropout is survived, a 20 minute one is not
+    feed(100, 200, 20 * 60);
+    gap(10 * 60);
+    TEST_ASSERT_EQUAL_UINT16(100, engine.result().pm2p5Hour);
+    gap(10 * 60);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, engine.result().pm2p5Hour);
+}
+
+// A reading stands for its sample period, so the POWER_LOW periods fill
+// every minute (power.h)
+static void test_reading_covers_period() {
+    static const uint32_t periods[] = {1, 60, 90, 300, 3600};
+    for (uint8_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+        engine.clear();
+        feed(100, 200, 14 * 3600, periods[i]);
+        aqi_t aqi = engine.result();
+        TEST_ASSERT_EQUAL_UINT16(100, aqi.pm2p5Hour);
+        TEST_ASSERT_EQUAL_UINT16(100, aqi.pm2p5NowCast);
+        TEST_ASSERT_EQUAL_UINT16(53, aqi.us);
+        TEST_ASSERT_EQUAL(AQI_MODERATE, aqi.usCategory);
+    }
+}
+
+// A reading that only stands for a second leaves the minutes after it empty
+static void test_short_cover_leaves_gaps() {
+    for (uint32_t t = 0; t < 2 * 3600; t += 300) {
+        engine.add(now, 100, 200, SECOND_US);
+        now += 300 * SECOND_US;
+    }
+    engine.advance(now);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, engine.result().pm2p5Hour);
+}
+
+// Daily means and CAQI once 18 of 24 hours are in
+static void test_day_mean() {
+    feed(80, 120, 17 * 3600, 60);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, engine.result().pm2p5Day);
+    feed(80, 120, 3600, 60);
+    aqi_t aqi = engine.result();
+    TEST_ASSERT_EQUAL_UINT16(80, aqi.pm2p5Day);
+    TEST_ASSERT_EQUAL_UINT16(120, aqi.pm10Day);
+    TEST_ASSERT_EQUAL_UINT16(aqiCaqiDaily(80, 120), aqi.caqiDay);
+    TEST_ASSERT_EQUAL_UINT16(aqiCaqiHourly(80, 120), aqi.caqiHour);
+}
+
+// EPA NowCast in floating point: c[0] newest, w = min/max, at least 1/2
+static double referenceNowCast(const uint16_t *c, uint8_t n) {
+    double lo = c[0], hi = c[0];
+    for (uint8_t i = 0; i < n; i++) {
+        lo = c[i] < lo ? c[i] : lo;
+        hi = c[i] > hi ? c[i] : hi;
+    }
+    double w = hi > 0 ? lo / hi : 1;
+    w = w < 0.5 ? 0.5 : w;
+    double sum = 0, weights = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        sum += pow(w, i) * c[i];
+        weights += pow(w, i);
+    }
+    return sum / weights;
+}
+
+// NowCast from 2 hours on, against the reference for varying hourly means
+// (gentle ones, w above 1/2, and a spike that pins it there)
+static void test_nowcast() {
+    static const uint16_t hours[] = {120, 110, 100, 130, 125, 140, 150, 135, 120, 115, 105, 100,
+                                     90, 600, 80, 85};
+    const uint8_t n = sizeof(hours) / sizeof(hours[0]);
+    for (uint8_t h = 0; h < n; h++) {
+        feed(hours[h], hours[h], 3600, 60);
+        uint16_t nowCast = engine.result().pm2p5NowCast;
+        if (h == 0) {
+            TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, nowCast);
+            continue;
+        }
+        uint16_t recent[AQI_NOWCAST_HOURS];
+        uint8_t count = 0;
+        for (int8_t i = h; i >= 0 && count < AQI_NOWCAST_HOURS; i--) {
+            recent[count++] = hours[i];
+        }
+        TEST_ASSERT_UINT16_WITHIN(1, lround(referenceNowCast(recent, count)), nowCast);
+    }
+}
+
+// The micros() wrap (every ~71 minutes) in the middle of a run
+static void test_micros_wrap() {
+    now = 0xFFFFFFFFu - 30 * 60 * SECOND_US;
+    feed(100, 200, 3 * 3600, 10);
+    aqi_t aqi = engine.result();
+    TEST_ASSERT_EQUAL_UINT16(100, aqi.pm2p5Hour);
+    TEST_ASSERT_EQUAL_UINT16(100, aqi.pm2p5NowCast);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_us_pm2p5_breakpoints);
+    RUN_TEST(test_us_pm10_breakpoints);
+    RUN_TEST(test_caqi_breakpoints);
+    RUN_TEST(test_categories);
+    RUN_TEST(test_hour_mean_needs_75_percent);
+    RUN_TEST(test_reading_covers_period);
+    RUN_TEST(test_short_cover_leaves_gaps);
+    RUN_TEST(test_day_mean);
+    RUN_TEST(test_nowcast);
+    RUN_TEST(test_micros_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+// enginair test_history_codec
+// HistoryEncoder/HistoryDecoder (history_codec.h): records come back
+// bit-exact, whatever the values, and a block never outgrows its buffer.
+
+#include <unity.h>
+#include <string.h>
+#include "history_codec.h"
+
+#define RECORDS 600
+
+static history_record_t records[RECORDS];
+// Room for RECORDS worst case records
+static uint8_t block[RECORDS * CODEC_MAX_RECORD_BITS / 8 + 8];
+static uint32_t seed;
+static uint32_t encodedBytes; // of the last roundTrip()
+
+// Repeatable noise (LCG)
+static uint32_t noise() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+void setUp() {
+    seed = 1;
+    memset(block, 0xA5, sizeof(block));
+}
+
+void tearDown() {}
+
+// Encode n records into a block of size bytes, decode them again and
+// compare. Returns how many fitted.
+static uint32_t roundTrip(uint32_t n, uint32_t size) {
+    HistoryEncoder encoder;
+    encoder.begin(block, size);
+    uint32_t count = 0;
+    while (count < n && encoder.add(records[count])) {
+        count++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(count, encoder.count());
+    TEST_ASSERT_LESS_OR_EQUAL(size, encoder.bytes());
+    encodedBytes = encoder.bytes();
+
+    HistoryDecoder decoder;
+    decoder.begin(block, encoder.bytes());
+    for (uint32_t i = 0; i < count; i++) {
+        history_record_t record;
+        TEST_ASSERT_TRUE(decoder.next(record));
+        TEST_ASSERT_EQUAL_UINT32(records[i].time, record.time);
+        TEST_ASSERT_EQUAL_MEMORY(records[i].value, record.value, sizeof(record.value));
+    }
+    return count;
+}
+
+// A 1 Hz trace as the sensors produce it: noisy PM, CO2/T/RH moving every 5 s
+static void test_steady_trace() {
+    uint16_t co2 = 600, temp = 26000, humi = 30000;
+    for (uint32_t i = 0; i < RECORDS; i++) {
+        history_record_t &r = records[i];
+        r.time = 100 + i;
+        uint16_t pm = 80 + noise() % 20;
+        r.value[CH_PM1P0] = pm - 10;
+        r.value[CH_PM2P5] = pm;
+        r.value[CH_PM4P0] = pm + 3;
+        r.value[CH_PM10P0] = pm + 5;
+        if (i % 5 == 0) {
+            co2 += noise() % 7 - 3;
+            temp += noise() % 65 - 32;
+            humi += noise() % 129 - 64;
+        }
+        r.value[CH_CO2] = co2;
+        r.value[CH_TEMP] = temp;
+        r.value[CH_HUMI] = humi;
+    }
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, roundTrip(RECORDS, sizeof(block)));
+    // history_codec.h quotes about 2.5 bytes a record for this
+    TEST_ASSERT_LESS_OR_EQUAL(RECORDS * 3, encodedBytes);
+}
+
+// Full-range values, HISTORY_INVALID gaps, time jumps of every size class
+static void test_extremes() {
+    static const uint32_t steps[] = {1, 0, 2, 60, 1, 300, 3600, 1, 86400, 0x7FFFFFFF, 1, 5};
+    uint32_t time = 0;
+    for (uint32_t i = 0; i < RECORDS; i++) {
+        history_record_t &r = records[i];
+        time += steps[i % (sizeof(steps) / sizeof(steps[0]))];
+        r.time = time;
+        for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+            switch (noise() % 4) {
+                case 0: r.value[c] = 0; break;
+                case 1: r.value[c] = HISTORY_INVALID; break;
+                default: r.value[c] = noise(); break;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, roundTrip(RECORDS, sizeof(block)));
+}
+
+// A full block refuses the next record and leaves what it has intact
+static void test_block_full() {
+    for (uint32_t i = 0; i < RECORDS; i++) {
+        records[i].time = noise();
+        for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+            records[i].value[c] = noise();
+        }
+    }
+    uint32_t count = roundTrip(RECORDS, 256);
+    TEST_ASSERT_TRUE(count > 0 && count < RECORDS);
+    // Nothing written past the block
+    for (uint32_t i = 256; i < sizeof(block); i++) {
+        TEST_ASSERT_EQUAL_HEX8(0xA5, block[i]);
+    }
+}
+
+// Too small for even one worst case record
+static void test_block_too_small() {
+    memset(records, 0, sizeof(records));
+    TEST_ASSERT_EQUAL_UINT32(0, roundTrip(1, CODEC_MAX_RECORD_BITS / 8));
+}
+
+// Reading past the data fails instead of inventing records
+static void test_decoder_overrun() {
+    test_steady_trace();
+    HistoryEncoder encoder;
+    encoder.begin(block, sizeof(block));
+    for (uint32_t i = 0; i < 10; i++) {
+        encoder.add(records[i]);
+    }
+    HistoryDecoder decoder;
+    decoder.begin(block, encoder.bytes());
+    history_record_t record;
+    uint32_t decoded = 0;
+    while (decoded < 1000 && decoder.next(record)) {
+        decoded++;
+    }
+    TEST_ASSERT_TRUE(decoded >= 10 && decoded < 1000);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_trace);
+    RUN_TEST(test_extremes);
+    RUN_TEST(test_block_full);
+    RUN_TEST(test_block_too_small);
+    RUN_TEST(test_decoder_overrun);
+    return UNITY_END();
+}
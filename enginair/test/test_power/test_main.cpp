@@ -0,0 +1,109 @@
+// enginair test_power
+// Power modes and the duty cycle accounting (power.h), on the simulated
+// clock (sim.h).
+
+#include <unity.h>
+#include "power.h"
+#include "sim.h"
+
+#define SECOND_US 1000000u
+
+void setUp() {}
+void tearDown() {}
+
+static void test_sample_period() {
+    power_config_t normal = {POWER_NORMAL, 60, POWER_WARMUP_S, 0};
+    TEST_ASSERT_EQUAL_UINT32(SECOND_US, powerSamplePeriodUs(normal));
+    TEST_ASSERT_FALSE(powerPmDutyCycled(normal));
+
+    power_config_t low = {POWER_LOW, POWER_LOW_PERIOD_S, POWER_WARMUP_S, POWER_DISPLAY_TIMEOUT_S};
+    TEST_ASSERT_EQUAL_UINT32(POWER_LOW_PERIOD_S * SECOND_US, powerSamplePeriodUs(low));
+    TEST_ASSERT_TRUE(powerPmDutyCycled(low));
+
+    // Longest period, still within the 32 bit sample clock
+    low.period = POWER_MAX_PERIOD_S;
+    TEST_ASSERT_EQUAL_UINT32(3600000000u, powerSamplePeriodUs(low));
+
+    // The SEN50 only idles when the gap after the warmup is worth it
+    low.period = POWER_WARMUP_S + POWER_IDLE_MIN_S - 1;
+    TEST_ASSERT_FALSE(powerPmDutyCycled(low));
+    low.period = POWER_WARMUP_S + POWER_IDLE_MIN_S;
+    TEST_ASSERT_TRUE(powerPmDutyCycled(low));
+}
+
+// Duty in 0.1%, rounded; average current between the datasheet idle and
+// active figures (SEN50: 2.6 and 70 mA)
+static void test_duty_and_average() {
+    power_usage_t from = {};
+    power_usage_t to = {};
+    from.time = 5 * SECOND_US;
+    to.time = from.time + 100 * SECOND_US;
+    from.active[POWER_SEN50] = 7 * SECOND_US;
+    to.active[POWER_SEN50] = from.active[POWER_SEN50] + 25 * SECOND_US;
+    TEST_ASSERT_EQUAL_UINT16(250, powerDuty(from, to, POWER_SEN50));
+    TEST_ASSERT_EQUAL_UINT32(2600 + (70000 - 2600) / 4, powerAverageUa(from, to, POWER_SEN50));
+
+    // Never active, always active, and rounding
+    TEST_ASSERT_EQUAL_UINT16(0, powerDuty(from, to, POWER_OLED));
+    TEST_ASSERT_EQUAL_UINT32(10, powerAverageUa(from, to, POWER_OLED));
+    to.active[POWER_OLED] = 100 * SECOND_US;
+    TEST_ASSERT_EQUAL_UINT16(1000, powerDuty(from, to, POWER_OLED));
+    TEST_ASSERT_EQUAL_UINT32(10000, powerAverageUa(from, to, POWER_OLED));
+    to.active[POWER_CORE0] = 100 * SECOND_US / 3;
+    TEST_ASSERT_EQUAL_UINT16(333, powerDuty(from, to, POWER_CORE0));
+
+    // Below the 0.1% resolution of the duty, the average still moves
+    to.active[POWER_CORE1] = 50000; // 0.05%
+    TEST_ASSERT_EQUAL_UINT16(1, powerDuty(from, to, POWER_CORE1));
+    TEST_ASSERT_EQUAL_UINT32(4003, powerAverageUa(from, to, POWER_CORE1));
+
+    // Over-counted activity is capped at the interval
+    to.active[POWER_SEN50] = 500 * SECOND_US;
+    TEST_ASSERT_EQUAL_UINT16(1000, powerDuty(from, to, POWER_SEN50));
+    TEST_ASSERT_EQUAL_UINT32(70000, powerAverageUa(from, to, POWER_SEN50));
+
+    // An empty interval
+    TEST_ASSERT_EQUAL_UINT16(0, powerDuty(from, from, POWER_SEN50));
+    TEST_ASSERT_EQUAL_UINT32(2600, powerAverageUa(from, from, POWER_SEN50));
+}
+
+// Tallies follow the state changes on the clock, including a stretch that
+// is still running when the usage is taken
+static void test_tally() {
+    power_usage_t start = powerUsage();
+    uint64_t t = simTime();
+
+    powerSetActive(POWER_SEN50, true);
+    simAdvanceTo(t + 30 * SECOND_US);
+    powerSetActive(POWER_SEN50, true); // no change: no double count
+    simAdvanceTo(t + 40 * SECOND_US);
+    powerSetActive(POWER_SEN50, false);
+    simAdvanceTo(t + 90 * SECOND_US);
+    powerSetActive(POWER_SEN50, true);
+    powerAddActive(POWER_CORE0, 2 * SECOND_US);
+    powerAddActive(POWER_CORE0, 3 * SECOND_US);
+    simAdvanceTo(t + 100 * SECOND_US);
+
+    power_usage_t end = powerUsage();
+    TEST_ASSERT_EQUAL_UINT32(100 * SECOND_US, end.time - start.time);
+    TEST_ASSERT_EQUAL_UINT32(50 * SECOND_US, end.active[POWER_SEN50] - start.active[POWER_SEN50]);
+    TEST_ASSERT_EQUAL_UINT16(500, powerDuty(start, end, POWER_SEN50));
+    TEST_ASSERT_EQUAL_UINT16(50, powerDuty(start, end, POWER_CORE0));
+    TEST_ASSERT_EQUAL_UINT16(0, powerDuty(start, end, POWER_SCD40));
+    powerSetActive(POWER_SEN50, false);
+}
+
+static void test_component_names() {
+    TEST_ASSERT_EQUAL_STRING("core0", powerComponentName(POWER_CORE0));
+    TEST_ASSERT_EQUAL_STRING("sen50", powerComponentName(POWER_SEN50));
+    TEST_ASSERT_EQUAL_STRING("oled", powerComponentName(POWER_OLED));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_period);
+    RUN_TEST(test_duty_and_average);
+    RUN_TEST(test_tally);
+    RUN_TEST(test_component_names);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+// enginair test_stats
+// Streaming statistics (stats.h) against brute force over the same window,
+// sample by sample, including while the windows are still filling.
+
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+
+#define SAMPLES 2000
+#define WINDOW 37 // not a power of two, so the ring indices wrap unevenly
+
+static uint16_t data[SAMPLES];
+static uint32_t seed;
+
+static uint32_t noise() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Noise with runs, steps and plateaus, which exercise the deques and the
+// duplicate handling of the sorted window
+static void makeData() {
+    uint16_t level = 100;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        switch (noise() % 8) {
+            case 0: level = noise() % 1000; break;
+            case 1: break; // repeat
+            default: level += noise() % 21 - 10; break;
+        }
+        data[i] = level;
+    }
+    data[SAMPLES / 2] = 0;
+    data[SAMPLES / 2 + 1] = 0xFFFF;
+}
+
+void setUp() {
+    seed = 7;
+    makeData();
+}
+
+void tearDown() {}
+
+static int compare(const void *a, const void *b) {
+    return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+// The window ending at sample i, sorted
+static uint16_t sortedWindow(uint32_t i, uint16_t *out) {
+    uint16_t n = i + 1 < WINDOW ? i + 1 : WINDOW;
+    memcpy(out, data + i + 1 - n, n * sizeof(uint16_t));
+    qsort(out, n, sizeof(uint16_t), compare);
+    return n;
+}
+
+static void test_minmax_window() {
+    MinMaxWindow<WINDOW> window;
+    uint16_t sorted[WINDOW];
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        window.push(data[i]);
+        uint16_t n = sortedWindow(i, sorted);
+        TEST_ASSERT_EQUAL_UINT16(sorted[0], window.minimum());
+        TEST_ASSERT_EQUAL_UINT16(sorted[n - 1], window.maximum());
+    }
+    window.clear();
+    window.push(5);
+    TEST_ASSERT_EQUAL_UINT16(5, window.minimum());
+    TEST_ASSERT_EQUAL_UINT16(5, window.maximum());
+}
+
+// Percentiles are the sample at the nearest rank
+static void test_percentile_window() {
+    static const uint8_t percents[] = {0, 10, 50, 90, 100};
+    PercentileWindow<WINDOW> window;
+    uint16_t sorted[WINDOW];
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        window.push(data[i]);
+        uint16_t n = sortedWindow(i, sorted);
+        TEST_ASSERT_EQUAL_UINT16(n, window.count());
+        for (uint8_t p = 0; p < sizeof(percents); p++) {
+            uint16_t rank = ((uint32_t)(n - 1) * percents[p] + 50) / 100;
+            TEST_ASSERT_EQUAL_UINT16(sorted[rank], window.percentile(percents[p]));
+        }
+        TEST_ASSERT_EQUAL_UINT16(sorted[n / 2], window.median());
+    }
+}
+
+// Seeded by the first sample, and settles exactly on a step rather than a
+// few ticks short of it
+static void test_ewma() {
+    Ewma<8> ewma;
+    ewma.push(500);
+    TEST_ASSERT_EQUAL_UINT16(500, ewma.value());
+    for (uint32_t i = 0; i < 20 * 256; i++) {
+        ewma.push(510);
+    }
+    TEST_ASSERT_EQUAL_UINT16(510, ewma.value());
+    for (uint32_t i = 0; i < 20 * 256; i++) {
+        ewma.push(490);
+    }
+    TEST_ASSERT_EQUAL_UINT16(490, ewma.value());
+
+    // One time constant takes it about 63% of the way
+    Ewma<3> fast;
+    fast.push(0);
+    for (uint8_t i = 0; i < 8; i++) {
+        fast.push(1000);
+    }
+    TEST_ASSERT_UINT16_WITHIN(30, 656, fast.value()); // 1 - (7/8)^8
+
+    fast.clear();
+    fast.push(42);
+    TEST_ASSERT_EQUAL_UINT16(42, fast.value());
+}
+
+// The summary the firmware sends with each sample, and the view selection
+static void test_stream_stats() {
+    StreamStats stats;
+    TEST_ASSERT_EQUAL_UINT16(0, stats.summary().count);
+    TEST_ASSERT_EQUAL_UINT16(77, statsView(stats.summary(), STATS_MEDIAN, 77));
+
+    for (uint16_t i = 1; i <= 100; i++) {
+        stats.push(i);
+    }
+    stats_summary_t s = stats.summary();
+    TEST_ASSERT_EQUAL_UINT16(STATS_MEDIAN_WINDOW, s.count);
+    TEST_ASSERT_EQUAL_UINT16(1, s.min); // the min/max window is longer
+    TEST_ASSERT_EQUAL_UINT16(100, s.max);
+    TEST_ASSERT_EQUAL_UINT16(71, s.median); // 41..100
+    TEST_ASSERT_EQUAL_UINT16(94, s.p90);
+    TEST_ASSERT_TRUE(s.fast > s.mid && s.mid > s.slow);
+
+    TEST_ASSERT_EQUAL_UINT16(s.median, statsView(s, STATS_MEDIAN, 0));
+    TEST_ASSERT_EQUAL_UINT16(s.p90, statsView(s, STATS_P90, 0));
+    TEST_ASSERT_EQUAL_UINT16(s.min, statsView(s, STATS_MIN, 0));
+    TEST_ASSERT_EQUAL_UINT16(123, statsView(s, STATS_RAW, 123));
+    TEST_ASSERT_EQUAL_STRING("p90", statsViewName(STATS_P90));
+
+    stats.clear();
+    TEST_ASSERT_EQUAL_UINT16(0, stats.summary().count);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_minmax_window);
+    RUN_TEST(test_percentile_window);
+    RUN_TEST(test_ewma);
+    RUN_TEST(test_stream_stats);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// enginair test_telemetry
+// Binary telemetry framing (telemetry.h): what telemetrySend() puts on the
+// serial port is read back the way tools/telemetry.py does, by splitting at
+// the delimiters, undoing COBS and checking the CRC-16.
+
+#include <unity.h>
+#include <string.h>
+#include "telemetry.h"
+#include "crc16.h"
+#include "sim.h"
+
+#define MAX_FRAMES 8
+
+struct frame_t {
+    uint8_t type;
+    uint8_t body[TELEMETRY_MAX_BODY];
+    uint8_t length;
+};
+
+static uint8_t wire[1024];
+static frame_t frames[MAX_FRAMES];
+
+void setUp() {
+    simSerialCapture(wire, sizeof(wire));
+}
+
+void tearDown() {
+    simSerialCapture(nullptr, 0);
+}
+
+// Undo COBS; returns the decoded length, 0 for a malformed frame
+static uint32_t cobsDecode(const uint8_t *in, uint32_t length, uint8_t *out) {
+    uint32_t o = 0;
+    for (uint32_t i = 0; i < length;) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            out[o++] = in[i++];
+        }
+        if (code < 0xFF && i < length) {
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+// Split the captured output into frames, checking each on the way. Returns
+// the number of frames.
+static uint32_t parse() {
+    uint32_t size = simSerialCaptured();
+    TEST_ASSERT_TRUE(size > 0);
+    TEST_ASSERT_EQUAL_HEX8(0, wire[0]);
+    TEST_ASSERT_EQUAL_HEX8(0, wire[size - 1]);
+
+    uint32_t count = 0;
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (wire[i] != 0) {
+            continue;
+        }
+        if (i > start) {
+            uint8_t message[TELEMETRY_MAX_BODY + 8];
+            uint32_t n = cobsDecode(wire + start, i - start, message);
+            TEST_ASSERT_TRUE(n >= 4 && n <= TELEMETRY_MAX_BODY + 4);
+            uint16_t crc = message[n - 2] | message[n - 1] << 8;
+            TEST_ASSERT_EQUAL_HEX16(crc16(CRC16_INIT, message, n - 2), crc);
+            TEST_ASSERT_EQUAL_UINT8(TELEMETRY_VERSION, message[0]);
+            TEST_ASSERT_TRUE(count < MAX_FRAMES);
+            frames[count].type = message[1];
+            frames[count].length = n - 4;
+            memcpy(frames[count].body, message + 2, n - 4);
+            count++;
+        }
+        start = i + 1;
+    }
+    return count;
+}
+
+// CRC-16/CCITT-FALSE check value, and continuing a CRC across calls
+static void test_crc16() {
+    const char *check = "123456789";
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16(CRC16_INIT, check, 9));
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16(crc16(CRC16_INIT, check, 4), check + 4, 5));
+    TEST_ASSERT_EQUAL_HEX16(CRC16_INIT, crc16(CRC16_INIT, check, 0));
+}
+
+// Bodies of zeros, of no zeros and of a mix come back as they went in
+static void test_send_round_trip() {
+    uint8_t zeros[TELEMETRY_MAX_BODY] = {};
+    uint8_t ones[TELEMETRY_MAX_BODY];
+    uint8_t mixed[TELEMETRY_MAX_BODY];
+    for (uint8_t i = 0; i < TELEMETRY_MAX_BODY; i++) {
+        ones[i] = 0xFF - i;
+        mixed[i] = i % 3 ? i : 0;
+    }
+    telemetrySend(TELEMETRY_STATS, zeros, sizeof(zeros));
+    telemetrySend(TELEMETRY_TRACE, ones, sizeof(ones));
+    telemetrySend(TELEMETRY_ERROR, mixed, 7);
+    telemetrySend(TELEMETRY_STATS, nullptr, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(4, parse());
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_STATS, frames[0].type);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(zeros), frames[0].length);
+    TEST_ASSERT_EQUAL_MEMORY(zeros, frames[0].body, sizeof(zeros));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_TRACE, frames[1].type);
+    TEST_ASSERT_EQUAL_MEMORY(ones, frames[1].body, sizeof(ones));
+    TEST_ASSERT_EQUAL_UINT8(7, frames[2].length);
+    TEST_ASSERT_EQUAL_MEMORY(mixed, frames[2].body, 7);
+    TEST_ASSERT_EQUAL_UINT8(0, frames[3].length);
+}
+
+// Bodies over TELEMETRY_MAX_BODY are cut, not overrun
+static void test_send_truncates() {
+    uint8_t big[TELEMETRY_MAX_BODY + 20];
+    memset(big, 0x5A, sizeof(big));
+    telemetrySend(TELEMETRY_TRACE, big, sizeof(big));
+    TEST_ASSERT_EQUAL_UINT32(1, parse());
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_MAX_BODY, frames[0].length);
+}
+
+// A sample frame carries the sample, with the sequence counting up; the
+// statistics and AQI frames follow only once there is something to send
+static void test_sample_frames() {
+    sample_t sample = {};
+    sample.time = 123456789;
+    sample.flags = SAMPLE_PM_VALID | SAMPLE_CO2_VALID;
+    sample.pm2p5 = 105;
+    sample.co2 = 0; // zero bytes in the body
+    sample.temp = 0x6400;
+    telemetrySample(sample);
+    telemetrySample(sample);
+    TEST_ASSERT_EQUAL_UINT32(2, parse());
+
+    telemetry_sample_t first, second;
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_SAMPLE, frames[0].type);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(first), frames[0].length);
+    memcpy(&first, frames[0].body, sizeof(first));
+    memcpy(&second, frames[1].body, sizeof(second));
+    TEST_ASSERT_EQUAL_UINT32(sample.time, first.time);
+    TEST_ASSERT_EQUAL_UINT8(sample.flags, first.flags);
+    TEST_ASSERT_EQUAL_UINT16(105, first.pm2p5);
+    TEST_ASSERT_EQUAL_UINT16(0x6400, first.temp);
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)(first.sequence + 1), second.sequence);
+
+    simSerialCapture(wire, sizeof(wire));
+    sample.pm2p5Stats.count = 10;
+    sample.pm2p5Stats.median = 100;
+    sample.aqi.pm2p5Hour = 100;
+    sample.aqi.us = 53;
+    telemetrySample(sample);
+    telemetrySample(sample); // same indices: no second AQI frame
+    TEST_ASSERT_EQUAL_UINT32(5, parse());
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_PM_STATS, frames[1].type);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_AQI, frames[2].type);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_PM_STATS, frames[4].type);
+    telemetry_aqi_t aqi;
+    memcpy(&aqi, frames[2].body, sizeof(aqi));
+    TEST_ASSERT_EQUAL_UINT16(53, aqi.us);
+    TEST_ASSERT_EQUAL_UINT16(AQI_INVALID, aqi.caqiDay);
+}
+
+// Error frames: the code, then as much of the context as fits
+static void test_error_frame() {
+    const char *context = "a context far longer than the forty-eight bytes of a body";
+    telemetryError(context, 0x0105);
+    TEST_ASSERT_EQUAL_UINT32(1, parse());
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_ERROR, frames[0].type);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_MAX_BODY, frames[0].length);
+    telemetry_error_t error;
+    memcpy(&error, frames[0].body, sizeof(error));
+    TEST_ASSERT_EQUAL_HEX16(0x0105, error.code);
+    TEST_ASSERT_EQUAL_MEMORY(context, frames[0].body + sizeof(error),
+                             TELEMETRY_MAX_BODY - sizeof(error));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16);
+    RUN_TEST(test_send_round_trip);
+    RUN_TEST(test_send_truncates);
+    RUN_TEST(test_sample_frames);
+    RUN_TEST(test_error_frame);
+    return UNITY_END();
+}
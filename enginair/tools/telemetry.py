@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Reference decoder for enginair binary telemetry (include/telemetry.h).
+
+Reads the device's serial output, splits it into 0x00 delimited COBS frames,
+checks the CRC-16 and prints one line per message. Anything that isn't a
+valid frame (console replies, text output from before 'output binary') is
+skipped, and decoding resyncs at the next delimiter.
+
+    python3 tools/telemetry.py /dev/ttyACM0      # needs pyserial
+    python3 tools/telemetry.py capture.bin       # a saved capture
+    python3 tools/telemetry.py -                 # stdin
+
+With --trace FILE, sensor trace frames (trace.h) are also written to FILE in
+the text format the native build replays (native/sim_replay.h):
+
+    python3 tools/telemetry.py --trace trace.txt /dev/ttyACM0
+"""
+
+import struct
+import sys
+
+VERSION = 1
+SAMPLE, ERROR, STATS, TRACE, PM_STATS, AQI = 1, 2, 3, 4, 5, 6
+TRACE_WRITE, TRACE_READ = 0, 1
+
+SAMPLE_PM_VALID, SAMPLE_CO2_VALID, SAMPLE_CO2_NEW = 1, 2, 4
+
+SAMPLE_FORMAT = struct.Struct("<HIB7H")
+ERROR_FORMAT = struct.Struct("<H")
+STATS_FORMAT = struct.Struct("<8I")
+TRACE_FORMAT = struct.Struct("<HIBBB")
+PM_STATS_FORMAT = struct.Struct("<I8H")
+AQI_FORMAT = struct.Struct("<I7HB2H")
+AQI_INVALID = 0xFFFF
+AQI_CATEGORIES = ("good", "moderate", "sensitive", "unhealthy", "very unhealthy", "hazardous")
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as src/crc16.cpp"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            raise ValueError("bad COBS block")
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(frame):
+    """Returns (type, body) or None if the frame is not a valid message."""
+    try:
+        message = cobs_decode(frame)
+    except ValueError:
+        return None
+    if len(message) < 4:
+        return None
+    payload, crc = message[:-2], struct.unpack("<H", message[-2:])[0]
+    if crc16(payload) != crc or payload[0] != VERSION:
+        return None
+    return payload[1], payload[2:]
+
+
+def temp_c(ticks):
+    return -45 + 175 * ticks / 65536
+
+
+def humi_pct(ticks):
+    return 100 * ticks / 65536
+
+
+def pm_or_dash(ticks):
+    return "--" if ticks == AQI_INVALID else f"{ticks / 10:.1f}"
+
+
+def index_or_dash(index):
+    return "--" if index == AQI_INVALID else str(index)
+
+
+def format_message(kind, body):
+    if kind == SAMPLE and len(body) == SAMPLE_FORMAT.size:
+        seq, time, flags, pm1, pm25, pm4, pm10, co2, temp, humi = SAMPLE_FORMAT.unpack(body)
+        line = f"sample #{seq} {time / 1e6:.3f}s"
+        if flags & SAMPLE_PM_VALID:
+            line += f" PM1.0 {pm1 / 10:.1f} PM2.5 {pm25 / 10:.1f} PM4.0 {pm4 / 10:.1f} PM10 {pm10 / 10:.1f}"
+        if flags & SAMPLE_CO2_VALID:
+            new = "*" if flags & SAMPLE_CO2_NEW else ""
+            line += f" CO2 {co2}{new} T {temp_c(temp):.1f} RH {humi_pct(humi):.1f}"
+        return line
+    if kind == ERROR and len(body) >= ERROR_FORMAT.size:
+        (code,) = ERROR_FORMAT.unpack(body[:ERROR_FORMAT.size])
+        context = body[ERROR_FORMAT.size:].decode("ascii", "replace")
+        return f"error 0x{code:04x} {context}"
+    if kind == STATS and len(body) == STATS_FORMAT.size:
+        fields = STATS_FORMAT.unpack(body)
+        names = ("time", "dropped", "co2_checks", "co2_reads", "co2_saved",
+                 "co2_misses", "oled_frames", "oled_skipped")
+        return "stats " + " ".join(f"{n}={v}" for n, v in zip(names, fields))
+    if kind == PM_STATS and len(body) == PM_STATS_FORMAT.size:
+        time, count, *values = PM_STATS_FORMAT.unpack(body)
+        names = ("fast", "mid", "slow", "min", "max", "median", "p90")
+        return f"pm2.5 {time / 1e6:.3f}s n={count} " + " ".join(
+            f"{n}={v / 10:.1f}" for n, v in zip(names, values))
+    if kind == AQI and len(body) == AQI_FORMAT.size:
+        (time, pm25_hour, pm25_day, pm10_hour, pm10_day, pm25_now, pm10_now,
+         us, category, caqi_hour, caqi_day) = AQI_FORMAT.unpack(body)
+        name = AQI_CATEGORIES[category] if category < len(AQI_CATEGORIES) else "--"
+        return (f"aqi {time / 1e6:.3f}s US {index_or_dash(us)} ({name})"
+                f" CAQI 1h {index_or_dash(caqi_hour)} 24h {index_or_dash(caqi_day)}"
+                f" PM2.5 1h {pm_or_dash(pm25_hour)} 24h {pm_or_dash(pm25_day)} NowCast {pm_or_dash(pm25_now)}"
+                f" PM10 1h {pm_or_dash(pm10_hour)} 24h {pm_or_dash(pm10_day)} NowCast {pm_or_dash(pm10_now)}")
+    if kind == TRACE and len(body) >= TRACE_FORMAT.size:
+        seq, time, address, op, result = TRACE_FORMAT.unpack(body[:TRACE_FORMAT.size])
+        data = body[TRACE_FORMAT.size:].hex() or "-"
+        return f"trace #{seq} {time / 1e6:.6f}s 0x{address:02x} {'WR'[op]} {result} {data}"
+    return f"unknown type {kind} ({len(body)} bytes)"
+
+
+class TraceWriter:
+    """Writes trace frames as replay lines, with the 32-bit micros unwrapped
+    and sequence gaps reported (a trace with gaps won't replay faithfully)."""
+
+    def __init__(self, path):
+        self.out = open(path, "w")
+        self.out.write("# enginair sensor trace: micros address W|R result data\n")
+        self.sequence = None
+        self.last = None
+        self.epoch = 0
+        self.gaps = 0
+
+    def add(self, body):
+        seq, time, address, op, result = TRACE_FORMAT.unpack(body[:TRACE_FORMAT.size])
+        if self.sequence is not None and seq != (self.sequence + 1) & 0xFFFF:
+            self.gaps += 1
+            print(f"trace: entries lost before #{seq}", file=sys.stderr)
+        self.sequence = seq
+        if self.last is not None and time < self.last:
+            self.epoch += 1 << 32
+        self.last = time
+        data = body[TRACE_FORMAT.size:].hex() or "-"
+        self.out.write(f"{self.epoch + time} {address:02x} {'WR'[op]} {result} {data}\n")
+        self.out.flush()
+
+
+def frames(stream, live=False):
+    """Yield the bytes between delimiters. A live (serial) stream is read
+    until interrupted: an empty read there is a read timeout, not the end."""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            if live:
+                continue
+            return
+        buffer += chunk
+        while True:
+            end = buffer.find(0)
+            if end < 0:
+                break
+            yield bytes(buffer[:end])
+            del buffer[:end + 1]
+
+
+def open_source(name):
+    """The stream to read, and whether it is a live serial port"""
+    if name == "-":
+        return sys.stdin.buffer, False
+    if name.startswith("/dev/") or name.upper().startswith("COM"):
+        import serial  # pyserial
+        return serial.Serial(name, 115200, timeout=1), True
+    return open(name, "rb"), False
+
+
+def main():
+    args = sys.argv[1:]
+    trace = None
+    if len(args) == 3 and args[0] == "--trace":
+        trace = TraceWriter(args[1])
+        args = args[2:]
+    if len(args) != 1:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+    source, live = open_source(args[0])
+    skipped = 0
+    try:
+        for frame in frames(source, live):
+            if not frame:
+                continue  # back-to-back delimiters
+            message = decode_frame(frame)
+            if message is None:
+                skipped += 1
+                continue
+            if trace and message[0] == TRACE and len(message[1]) >= TRACE_FORMAT.size:
+                trace.add(message[1])
+            print(format_message(*message), flush=True)
+    except KeyboardInterrupt:
+        pass  # the way out of a live port
+    if skipped:
+        print(f"({skipped} invalid frames skipped)", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())